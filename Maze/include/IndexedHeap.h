@@ -0,0 +1,139 @@
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+/**
+ * @file IndexedHeap.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief The open list shared by UCS, Greedy and A*
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+/**
+ * @brief min-heap of ids with a position map, so every id is stored at most once and its key can be decreased in place
+ *
+ * 4-ary layout: the children of slot i are 4i+1 .. 4i+4, which keeps the heap half as deep as a binary one and
+ * makes siftDown compare four adjacent entries. With 16-byte entries those span 64 bytes but usually straddle two
+ * cache lines, since 4i+1 is not line-aligned.
+ */
+template <typename Key, size_t Arity = 4>
+class IndexedHeap {
+public:
+  static constexpr uint32_t NPOS = UINT32_MAX;
+
+  struct Entry {
+    Key key;
+    uint32_t id;
+  };
+
+  // 讓 id 的範圍變成 [0, id_count)，會清空整個 heap
+  void resize(const size_t id_count)
+  {
+    heap.clear();
+    position.assign(id_count, NPOS);
+  }
+
+  bool empty() const { return heap.empty(); }
+  size_t size() const { return heap.size(); }
+  size_t idCount() const { return position.size(); }
+  bool contains(const uint32_t id) const { return position[id] != NPOS; }
+  Key key(const uint32_t id) const { return heap[position[id]].key; }
+  const Entry &top() const { return heap.front(); }
+
+  /**
+   * @brief insert the id, or lower its key if it is already in the heap and the new key is smaller
+   *
+   * @return true if the id was inserted or its key decreased
+   */
+  bool pushOrDecrease(const uint32_t id, const Key key)
+  {
+    uint32_t pos = position[id];
+    if (pos == NPOS) {
+      pos = static_cast<uint32_t>(heap.size());
+      heap.push_back(Entry{ key, id });
+      position[id] = pos;
+    }
+    else if (key < heap[pos].key)
+      heap[pos].key = key;
+    else
+      return false;
+
+    siftUp(pos);
+    return true;
+  }
+
+  Entry pop()
+  {
+    const Entry top_entry = heap.front();
+    position[top_entry.id] = NPOS;
+
+    const Entry last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+      heap.front() = last;
+      position[last.id] = 0;
+      siftDown(0);
+    }
+    return top_entry;
+  }
+
+  // 只重設還在 heap 裡的 id，不用每次都清整個 position map
+  void clear()
+  {
+    for (const Entry &entry : heap)
+      position[entry.id] = NPOS;
+    heap.clear();
+  }
+
+private:
+  std::vector<Entry> heap;
+  std::vector<uint32_t> position;    // id -> slot in heap, NPOS if the id is not in the heap
+
+  void siftUp(uint32_t pos)
+  {
+    const Entry entry = heap[pos];
+    while (pos > 0) {
+      const uint32_t parent = (pos - 1) / Arity;
+      if (!(entry.key < heap[parent].key))
+        break;
+      heap[pos] = heap[parent];
+      position[heap[pos].id] = pos;
+      pos = parent;
+    }
+    heap[pos] = entry;
+    position[entry.id] = pos;
+  }
+
+  void siftDown(uint32_t pos)
+  {
+    const Entry entry = heap[pos];
+    const size_t count = heap.size();
+    while (true) {
+      const size_t first_child = static_cast<size_t>(pos) * Arity + 1;
+      if (first_child >= count)
+        break;
+
+      size_t best = first_child;
+      const size_t last_child = std::min(first_child + Arity, count);
+      for (size_t child = first_child + 1; child < last_child; ++child)
+        if (heap[child].key < heap[best].key)
+          best = child;
+
+      if (!(heap[best].key < entry.key))
+        break;
+      heap[pos] = heap[best];
+      position[heap[pos].id] = pos;
+      pos = static_cast<uint32_t>(best);
+    }
+    heap[pos] = entry;
+    position[entry.id] = pos;
+  }
+};
+
+#endif
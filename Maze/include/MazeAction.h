@@ -0,0 +1,38 @@
+#ifndef MAZEACTION_H
+#define MAZEACTION_H
+
+/**
+ * @file MazeAction.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief The actions the user can ask the maze for
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include <cstdint>
+
+enum class MazeAction : int32_t {
+  G_RESET,
+  G_PRIMS,
+  G_RECURSION_BACKTRACKER,
+  G_RECURSION_DIVISION,
+  G_GROWING_TREE_NEWEST,    // Growing Tree 每次拿最新的格子，和回溯法一樣長長的走廊
+  G_GROWING_TREE_RANDOM,    // 每次隨機拿一格，和 Prim's 一樣很多短的死路
+  G_GROWING_TREE_OLDEST,    // 每次拿最舊的格子，從起點往外放射
+  G_GROWING_TREE_MIXED,    // 75% 拿最新的，25% 隨機
+  S_DFS,
+  S_BFS,
+  S_UCS_MANHATTAN,    // Cost Function 為 Two_Norm，所以距離終點越遠 Cost 越大
+  S_UCS_TWO_NORM,    // Cost Function 為 Two_Norm，所以距離終點越遠 Cost 越大
+  S_UCS_INTERVAL,    // Cost Function 以區間來計算，每一個區間 Cost 差10，距離終點越遠 Cost 越大
+  S_GREEDY,
+  S_ASTAR,
+  S_ASTAR_INTERVAL
+};
+
+inline constexpr int32_t MAZE_ACTION_COUNT = static_cast<int32_t>(MazeAction::S_ASTAR_INTERVAL) + 1;
+inline constexpr const char *maze_action_name[MAZE_ACTION_COUNT]{
+  "Reset", "Prim's", "Backtracker", "Division", "GT Newest", "GT Random", "GT Oldest", "GT 75/25", "DFS", "BFS", "UCS Manhattan", "UCS Two Norm", "UCS Interval", "Greedy", "A*", "A* Interval"
+};
+
+#endif
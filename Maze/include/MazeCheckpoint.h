@@ -0,0 +1,67 @@
+#ifndef MAZECHECKPOINT_H
+#define MAZECHECKPOINT_H
+
+/**
+ * @file MazeCheckpoint.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Everything a generator needs to continue a run, and the file it is checkpointed to
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * File layout (little endian):
+ *   header    "MZCK", uint32 version, int32 algorithm, uint32 seed, int32 height, int32 width,
+ *             int32 begin_y, begin_x, end_y, end_x, uint64 nodes_expanded, pushes, pops, peak_open, peak_memory,
+ *             path_length, double elapsed_ms, int32 direction_order[4]
+ *   rng       uint64 length, the text form of the std::mt19937 state
+ *   explored  uint64 count, (int32 y, int32 x, int8 element) per node
+ *   frontier  uint64 count, same records
+ *   stack     uint64 count, (int32 y, int32 x, int8 element, int8 index, uint8 direction_order[4]) per frame
+ *   grid      height * width element bytes, row-major
+ *   footer    "MZCE"
+ *
+ * A checkpoint is written to path + ".tmp" and renamed over path, so a process killed while writing leaves the
+ * previous checkpoint intact.
+ */
+
+#include "MazeNode.h"
+#include "MazeAction.h"
+#include "MazeStats.h"
+#include "MazeGrid.h"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct MazeTraceFrame {    // 回溯法堆疊上的一格
+  MazeNode node;
+  int8_t index = 0;    // 下一個要試的方向
+  std::array<uint8_t, 4> direction_order = { 0, 1, 2, 3 };
+};
+
+/**
+ * @brief the working state of generateMazePrim / generateMazeRecursionBacktracker, the grid itself lives in the model
+ */
+struct MazeGeneratorState {
+  MazeAction algorithm = MazeAction::G_RESET;
+  uint32_t seed = 0;
+  std::mt19937 gen;
+  MazeStats stats;    // 到上一次 checkpoint 為止的計數，elapsed_ms 也是
+  std::array<int32_t, 4> direction_order{ 0, 1, 2, 3 };    // Prim 每次都在上一次洗過的順序上再洗
+  std::vector<MazeNode> explored_cache;    // 結束時要改回 GROUND 的格子
+  std::vector<MazeNode> frontier;    // Prim 的候選牆
+  std::vector<MazeTraceFrame> stack;    // 回溯法的堆疊
+};
+
+class MazeCheckpoint {
+public:
+  static constexpr uint32_t VERSION = 1;
+
+  static bool save(const std::string &path, const MazeGeneratorState &state, const MazeStats &stats, const MazeGrid &maze,
+                   const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x);
+  static bool load(const std::string &path, MazeGeneratorState &state, MazeGrid &maze,
+                   int32_t &begin_y, int32_t &begin_x, int32_t &end_y, int32_t &end_x);
+};
+
+#endif
@@ -10,36 +10,108 @@
  */
 
 #include "MazeModel.h"
+#include "MazeModelListener.h"
 #include "MazeView.h"
 #include "MazeNode.h"
+#include "MazeDiffBatch.h"
+#include "MazeAction.h"
+#include "MazeStats.h"
+#include "MazeReplay.h"
+#include "MazeGrid.h"
+#include "MazeFile.h"
+#include "MazeImage.h"
+#include "MazeJob.h"
+#include "MazeSharedGrid.h"
+#include "ThreadPool.h"
 
 #include <memory>
 #include <atomic>
+#include <array>
+#include <mutex>
+#include <string>
 
 class MazeModel;
 class MazeView;
 struct MazeNode;
-enum class MazeAction;
 
-class MazeController {
+class MazeController : public MazeModelListener {
 public:
+  static constexpr const char *REPLAY_PATH = "maze_replay.mzr";
+  static constexpr const char *MAZE_PATH = "maze.mzb";
+  static constexpr const char *IMAGE_PATH = "maze_export";    // 副檔名依格式決定
+  static constexpr const char *IMPORT_PATH = "maze_import.png";
+  static constexpr const char *CHECKPOINT_PATH = "maze.ckpt";
+  static constexpr const char *HEATMAP_PATH = "maze_heatmap";    // 圖檔加上格式的副檔名，raw 檔加上 _HxW.u32
+
+  /**
+   * @param worker_count size of the shared thread pool, 0 means one worker per hardware thread
+   * @param pin_workers pin each pool worker to its own CPU
+   */
+  explicit MazeController(const size_t worker_count = 0, const bool pin_workers = false);
+
   void setModelView(MazeModel *model_ptr, MazeView *view_ptr);
 
-  void handleInput(const MazeAction action);
-  void setFrameMaze(const std::vector<std::vector<MazeElement>> &maze);
-  void enFramequeue(const MazeNode &node);
+  MazeJobHandle handleInput(const MazeAction action);
+  void setFrameMaze(const MazeGrid &maze) override;
+  void enFramequeue(const MazeDiffBatch &batch) override;
 
-  void setModelComplete();
+  void setModelComplete() override;
   bool isModelComplete() const;
 
+  void setJobPolicy(const JobPolicy policy);
+  JobPolicy getJobPolicy() const;
+  void cancelJobs();
+  MazeJobHandle currentJob() const;
+  size_t pendingJobs() const;
+  bool isJobRunning() const;
+  ThreadPool &threadPool() override;
+
+  MazeJobHandle saveMaze(const std::string &path, const MazeEncoding encoding);
+  MazeJobHandle loadMaze(const std::string &path, const bool verify_checksum = true);
+  MazeJobHandle exportImage(const std::string &path, const MazeExportOptions &options, const bool with_solution);
+  MazeJobHandle importImage(const std::string &path, const MazeImportOptions &options);
+  void setCheckpoint(const std::string &path, const double interval_seconds);
+  bool publishGrid(const std::string &name, const double interval_ms = MazeSharedPublisher::DEFAULT_INTERVAL_MS);
+  MazeJobHandle resumeGeneration(const std::string &path);
+
+  void setRecording(const bool enable);
+  bool isRecording() const;
+
+  void setHeatmap(const bool enable);
+  bool isHeatmapEnabled() const;
+  std::shared_ptr<const MazeExpansionLayer> getHeatmap(uint64_t &version);
+  MazeJobHandle exportHeatmap(const std::string &path, const MazeExportOptions &options);
+
+  void recordStats(const MazeAction action, const MazeStats &stats);
+  MazeStats getStats(const MazeAction action);
+
   void InitMaze();
 
 public:
   std::atomic<bool> model_complete_flag{ false };
+  std::atomic<bool> record_flag{ false };    // 每次執行都把 diff 錄到 REPLAY_PATH
+  std::atomic<bool> heatmap_flag{ false };    // 解迷宮的時候記錄每一格的展開順序
 
 private:
   MazeModel *model_ptr;
   MazeView *view_ptr;
+
+  std::array<MazeStats, MAZE_ACTION_COUNT> last_stats;    // 每個演算法最後一次執行的統計
+  std::mutex stats_mutex;
+  std::shared_ptr<const MazeExpansionLayer> heatmap;    // 最後一次搜尋的展開順序，沒有的話是 nullptr
+  uint64_t heatmap_version = 0;    // heatmap 每換一次加一，畫面用來判斷要不要重算
+  std::mutex heatmap_mutex;
+  MazeReplayWriter replay_writer;    // 只有背景工作的 thread 會用
+  MazeSharedPublisher shared_publisher;    // 同上，把畫面上的迷宮放到 shared memory 給其他程式讀
+  std::atomic<JobPolicy> job_policy{ JobPolicy::CANCEL_PREVIOUS };
+  const std::atomic<bool> *cancel_token = nullptr;    // 正在跑的工作的取消旗標，只有背景工作的 thread 會用
+  bool resync_needed = false;    // 上一個工作被取消，畫面可能少了一些 diff，下一個工作開始前要整張重送
+
+  ThreadPool pool;    // 生成、解迷宮、匯出等所有平行的工作共用
+  std::unique_ptr<MazeJobScheduler> scheduler;    // 放最後面，解構時最先停下來，工作不會用到已經解構的成員
+
+  void runJob(MazeJob &job);
+  void publishHeatmap(const bool searched);
 };
 
 #endif
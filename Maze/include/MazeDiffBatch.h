@@ -0,0 +1,61 @@
+#ifndef MAZEDIFFBATCH_H
+#define MAZEDIFFBATCH_H
+
+/**
+ * @file MazeDiffBatch.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Fixed-size chunk of cell changes sent from the model to the view in one push
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include "MazeNode.h"
+
+#include <cstdint>
+
+/**
+ * @brief struct-of-arrays batch of diffs: single cells as (packed index, element byte), and run-length row spans
+ *
+ * Spans are applied before cells. A producer that wants a span after some cells has to publish the batch first,
+ * pushSpan refuses in that case, so the order inside the stream is always kept.
+ */
+struct MazeDiffBatch {
+  static constexpr uint32_t CELL_CAPACITY = 1024;
+  static constexpr uint32_t SPAN_CAPACITY = 64;
+  static constexpr uint32_t NO_CELL = UINT32_MAX;    // 不改任何格子，只把畫面上的 "目前節點" 清掉
+
+  uint32_t cell_count = 0;
+  uint32_t span_count = 0;
+  uint32_t cell_index[CELL_CAPACITY];    // y * width + x
+  MazeElement cell_element[CELL_CAPACITY];
+  uint32_t span_begin[SPAN_CAPACITY];    // 第一格的 y * width + x，span 不會跨行
+  uint32_t span_length[SPAN_CAPACITY];
+  MazeElement span_element[SPAN_CAPACITY];
+
+  bool empty() const { return cell_count == 0 && span_count == 0; }
+  void clear() { cell_count = span_count = 0; }
+
+  // 放不下就回傳 false，呼叫的人要先把這一批送出去
+  bool pushCell(const uint32_t index, const MazeElement element)
+  {
+    if (cell_count == CELL_CAPACITY)
+      return false;
+    cell_index[cell_count] = index;
+    cell_element[cell_count] = element;
+    ++cell_count;
+    return true;
+  }
+
+  bool pushSpan(const uint32_t begin, const uint32_t length, const MazeElement element)
+  {
+    if (span_count == SPAN_CAPACITY || cell_count != 0)
+      return false;
+    span_begin[span_count] = begin;
+    span_length[span_count] = length;
+    span_element[span_count] = element;
+    ++span_count;
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+/**
+ * @file MazeFile.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Save a maze to a versioned binary file, and open one by memory-mapping it
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * File layout (little endian):
+ *   header   128 bytes, see MazeFileHeader
+ *   payload  BYTE: one int8 MazeElement per cell, row-major
+ *            BIT:  one bit per cell (1 = not a wall), row-major, least significant bit first
+ *            RLE:  blocks of block_rows rows, then (block count + 1) uint64 file offsets of the blocks, the last one
+ *                  is the end of the blocks (index_offset). A block is a tag byte and
+ *                  RUNS: per row, varint (LEB128) lengths of alternating wall / ground runs, starting with a wall run
+ *                  BITS: the rows of the block packed like BIT, used when it is smaller than the runs
+ *   costs    optional, one uint8 step cost per cell, row-major
+ *
+ * The checksum is FNV-1a 64 over the payload followed by the cost layer, open() leaves it to verify() and
+ * MazeModel::loadMaze calls that unless told not to. A BYTE file is mapped copy-on-write and
+ * the model works on the mapped cells directly, so opening is O(1) and pages come in as the solvers touch them;
+ * changes never reach the file. BIT and RLE files are unpacked into memory when opened, the blocks of an RLE file
+ * decode independently so that happens in parallel, and streamRows() feeds any range of rows to a sink without
+ * building the grid at all.
+ */
+
+#include "MazeNode.h"
+#include "MazeAction.h"
+#include "MazeGrid.h"
+
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+enum class MazeEncoding : uint8_t {
+  BYTE,
+  BIT,    // 只記得是不是牆，EXPLORED / PATH 都會變回 GROUND
+  RLE,    // 和 BIT 一樣只記得牆，一段一段的牆 / 路壓縮成長度
+};
+
+// 一次收到一列，row 只在呼叫期間有效
+using MazeRowSink = std::function<void(const int32_t y, const MazeElement *row)>;
+
+struct MazeFileInfo {
+  int32_t height = 0, width = 0;
+  MazeEncoding encoding = MazeEncoding::BYTE;
+  int32_t block_rows = 64;    // RLE 一個 block 幾列，越小越能平行解碼，越大壓得越好
+  uint32_t seed = 0;
+  MazeAction algorithm = MazeAction::G_RESET;    // 生成這個迷宮的演算法
+  bool has_endpoints = false;
+  int32_t begin_y = 0, begin_x = 0, end_y = 0, end_x = 0;
+  bool has_costs = false;
+  uint64_t checksum = 0;
+};
+
+class MazeFile {
+public:
+  static constexpr uint32_t VERSION = 1;
+
+  static bool save(const std::string &path, const MazeGrid &grid, MazeFileInfo info, const uint8_t *costs = nullptr);
+
+  bool open(const std::string &path);
+  void close();
+  bool isOpen() const { return static_cast<bool>(mapping); }
+
+  const MazeFileInfo &info() const { return file_info; }
+  MazeGrid grid(ThreadPool *pool = nullptr) const;
+  bool streamRows(const int32_t y0, const int32_t y1, const MazeRowSink &sink) const;
+  const uint8_t *costs() const;
+  bool verify() const;
+
+private:
+  struct Mapping;
+
+  std::shared_ptr<Mapping> mapping;    // grid() 回傳的 grid 也會持有，檔案關掉之後還能用
+  MazeFileInfo file_info;
+  uint64_t payload_offset = 0, payload_bytes = 0, cost_offset = 0;
+  uint64_t index_offset = 0;    // RLE 的 block 索引
+
+  uint64_t blockOffset(const size_t block) const;
+  void paintEndpoints(const int32_t y, MazeElement *row) const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef MAZEGRID_H
+#define MAZEGRID_H
+
+/**
+ * @file MazeGrid.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Flat row-major grid of maze cells, either owned or a view over memory someone else owns (a mapped file)
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * grid[y] is a pointer to row y, so grid[y][x] reads the same as the old vector of rows. Copying a grid always
+ * produces an owned grid, moving one keeps whatever it points at alive.
+ */
+
+#include "MazeNode.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// 格子的索引 (parent、open list 的 id、diff 的 cell_index / span_begin) 都是 uint32，UINT32_MAX 又是 NO_CELL
+inline constexpr uint64_t MAX_MAZE_CELLS = UINT32_MAX - 1;
+
+inline bool fitsCellIndex(const int32_t height, const int32_t width)
+{
+  return height >= 0 && width >= 0 && static_cast<uint64_t>(height) * width <= MAX_MAZE_CELLS;
+}
+
+// (cell index, element) 畫在 grid 上面，例如解法的 EXPLORED / PATH，index 相同的話後面的蓋掉前面的
+using MazeOverlay = std::vector<std::pair<uint32_t, MazeElement>>;
+
+// 一次搜尋裡每一格是第幾個被展開的，row-major，0 代表沒有被展開
+struct MazeExpansionLayer {
+  int32_t height = 0, width = 0;
+  uint32_t expanded = 0;    // 最大的 index，也就是展開了幾格
+  std::vector<uint32_t> order;
+
+  bool empty() const { return order.empty(); }
+};
+
+class MazeGrid {
+public:
+  MazeGrid() = default;
+  MazeGrid(const int32_t height, const int32_t width, const MazeElement fill = MazeElement::GROUND)
+      : storage(static_cast<size_t>(height) * width, fill), cells{ storage.data() }, grid_height{ height }, grid_width{ width } {}
+
+  MazeGrid(const MazeGrid &other)
+      : storage(other.cells, other.cells + other.size()), cells{ storage.data() }, grid_height{ other.grid_height }, grid_width{ other.grid_width } {}
+  MazeGrid(MazeGrid &&other) noexcept { swap(other); }
+
+  MazeGrid &operator=(const MazeGrid &other)
+  {
+    if (this != &other) {
+      MazeGrid copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  MazeGrid &operator=(MazeGrid &&other) noexcept
+  {
+    MazeGrid moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  /**
+   * @brief wrap cells owned by someone else, owner is kept alive as long as the grid (or a grid moved from it) is
+   */
+  static MazeGrid wrap(MazeElement *cells, const int32_t height, const int32_t width, std::shared_ptr<void> owner)
+  {
+    MazeGrid grid;
+    grid.cells = cells;
+    grid.grid_height = height;
+    grid.grid_width = width;
+    grid.owner = std::move(owner);
+    return grid;
+  }
+
+  int32_t height() const { return grid_height; }
+  int32_t width() const { return grid_width; }
+  size_t size() const { return static_cast<size_t>(grid_height) * grid_width; }
+  bool empty() const { return size() == 0; }
+  bool isOwned() const { return !owner; }
+  bool sameShape(const MazeGrid &other) const { return grid_height == other.grid_height && grid_width == other.grid_width; }
+
+  MazeElement *data() { return cells; }
+  const MazeElement *data() const { return cells; }
+  MazeElement *operator[](const int32_t y) { return cells + static_cast<size_t>(y) * grid_width; }
+  const MazeElement *operator[](const int32_t y) const { return cells + static_cast<size_t>(y) * grid_width; }
+
+  void fill(const MazeElement element) { std::fill_n(cells, size(), element); }
+
+  void swap(MazeGrid &other) noexcept
+  {
+    storage.swap(other.storage);
+    owner.swap(other.owner);
+    std::swap(cells, other.cells);
+    std::swap(grid_height, other.grid_height);
+    std::swap(grid_width, other.grid_width);
+  }
+
+private:
+  std::vector<MazeElement> storage;    // 自己擁有的格子，wrap 出來的 grid 是空的
+  std::shared_ptr<void> owner;    // wrap 進來的記憶體的擁有者，例如檔案的 mapping
+  MazeElement *cells = nullptr;
+  int32_t grid_height = 0, grid_width = 0;
+};
+
+#endif
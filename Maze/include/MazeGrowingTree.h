@@ -0,0 +1,123 @@
+#ifndef MAZEGROWINGTREE_H
+#define MAZEGROWINGTREE_H
+
+/**
+ * @file MazeGrowingTree.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief The active set and the cell-selection policies of the Growing Tree generator
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * Growing Tree keeps a set of carved cells that may still have uncarved neighbours. Every step it picks one of them
+ * with the policy, carves to a random uncarved neighbour and adds it, or removes the cell if it has none left.
+ * Picking the newest cell gives the long corridors of the backtracker, picking a random one the short dead ends of
+ * Prim's, picking the oldest one corridors that radiate from the start.
+ *
+ * A policy is a struct with
+ *   static size_t select(size_t size, std::mt19937 &gen)    the position to take, 0 is the oldest cell
+ *   static constexpr bool reads_front / reads_back         whether the order at that end must be kept
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/**
+ * @brief ring buffer of cell indices in insertion order, push at the back and remove anywhere in O(1)
+ *
+ * Removing from the middle moves an element from one end into the hole. The end is chosen by the policy, the one
+ * it never reads, so newest or oldest picks still see the true insertion order.
+ */
+class GrowingTreeActiveSet {
+public:
+  void clear()
+  {
+    head = 0;
+    count = 0;
+  }
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+  size_t capacity() const { return cells.size(); }
+  uint32_t operator[](const size_t pos) const { return cells[(head + pos) & mask]; }
+
+  void push(const uint32_t cell)
+  {
+    if (count == cells.size())
+      grow();
+    cells[(head + count) & mask] = cell;
+    ++count;
+  }
+
+  /**
+   * @brief remove the cell at pos
+   *
+   * @param keep_back fill the hole from the front, so the order of the newest cells is kept
+   */
+  void erase(const size_t pos, const bool keep_back)
+  {
+    if (pos + 1 == count) {
+      --count;
+      return;
+    }
+    if (pos == 0 || keep_back) {
+      cells[(head + pos) & mask] = cells[head];    // pos == 0 的話就是自己蓋自己
+      head = (head + 1) & mask;
+    }
+    else
+      cells[(head + pos) & mask] = cells[(head + count - 1) & mask];
+    --count;
+  }
+
+private:
+  std::vector<uint32_t> cells;    // 容量一定是 2 的次方，位置用 & mask 繞回來
+  size_t head = 0;
+  size_t count = 0;
+  size_t mask = 0;
+
+  void grow()
+  {
+    std::vector<uint32_t> larger(cells.empty() ? 64 : 2 * cells.size());
+    for (size_t pos = 0; pos < count; ++pos)
+      larger[pos] = (*this)[pos];
+    cells.swap(larger);
+    head = 0;
+    mask = cells.size() - 1;
+  }
+};
+
+struct GrowingTreeNewest {
+  static constexpr bool reads_front = false;
+  static constexpr bool reads_back = true;
+  static size_t select(const size_t size, std::mt19937 &) { return size - 1; }
+};
+
+struct GrowingTreeOldest {
+  static constexpr bool reads_front = true;
+  static constexpr bool reads_back = false;
+  static size_t select(const size_t, std::mt19937 &) { return 0; }
+};
+
+struct GrowingTreeRandom {
+  static constexpr bool reads_front = false;
+  static constexpr bool reads_back = false;
+  static size_t select(const size_t size, std::mt19937 &gen) { return std::uniform_int_distribution<size_t>(0, size - 1)(gen); }
+};
+
+/**
+ * @brief use First with probability FirstPercent / 100 and Second otherwise, GrowingTreeMix<GrowingTreeNewest, GrowingTreeRandom, 75> is the 75/25 mix
+ */
+template <typename First, typename Second, uint32_t FirstPercent>
+struct GrowingTreeMix {
+  static_assert(FirstPercent <= 100, "FirstPercent is a percentage");
+  static constexpr bool reads_front = First::reads_front || Second::reads_front;
+  static constexpr bool reads_back = First::reads_back || Second::reads_back;
+
+  static size_t select(const size_t size, std::mt19937 &gen)
+  {
+    return std::uniform_int_distribution<uint32_t>(0, 99)(gen) < FirstPercent ? First::select(size, gen) : Second::select(size, gen);
+  }
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef MAZEIMAGE_H
+#define MAZEIMAGE_H
+
+/**
+ * @file MazeImage.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Export a maze grid (and the last solution painted over it) as a PGM, PPM or PNG image, and import one from an image
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * PGM / PPM are streamed: chunks of rows are encoded in parallel on the thread pool into a bounded window of
+ * buffers and written out in order, so the image is never held in memory and any maze size works. PNG goes
+ * through stb_image_write, which needs the whole image, so it is limited to MAX_PNG_BYTES.
+ *
+ * An expansion layer is exported the same way, expanded cells in a viridis ramp from the first expansion (dark) to the
+ * last (yellow) and the other cells in the palette colour of the maze, or as the raw uint32_t array.
+ *
+ * Import decodes any format stb_image reads (PNG, BMP, PNM, ...) and turns every pixels_per_cell square block into
+ * one cell: a wall when its mean luminance is below the threshold, otherwise ground. Blocks whose mean colour is
+ * within the tolerance of the begin / end colour keys become the begin / end point, the first one in row-major order
+ * wins. Bands of cell rows are converted in parallel on the pool.
+ */
+
+#include "MazeNode.h"
+#include "MazeGrid.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class ImageFormat : int32_t {
+  PGM,
+  PPM,
+  PNG,
+};
+
+// 0xRRGGBB，PGM 用亮度
+struct MazePalette {
+  uint32_t wall = 0x734046;
+  uint32_t ground = 0xFFFFFF;
+  uint32_t explored = 0xE79E4F;
+  uint32_t path = 0x3C78E6;
+  uint32_t begin = 0x23DC82;
+  uint32_t end = 0xFA3296;
+  uint32_t other = 0x000000;
+
+  uint32_t color(const MazeElement element) const
+  {
+    switch (element) {
+    case MazeElement::WALL: return wall;
+    case MazeElement::GROUND: return ground;
+    case MazeElement::EXPLORED: return explored;
+    case MazeElement::PATH: return path;
+    case MazeElement::BEGIN: return begin;
+    case MazeElement::END: return end;
+    default: return other;
+    }
+  }
+};
+
+struct MazeExportOptions {
+  ImageFormat format = ImageFormat::PPM;
+  int32_t pixels_per_cell = 1;
+  int32_t rows_per_chunk = 64;    // 一個平行工作負責幾列格子
+  MazePalette palette;
+};
+
+struct MazeImportOptions {
+  int32_t pixels_per_cell = 1;
+  uint8_t wall_threshold = 128;    // 平均亮度低於這個值就是牆
+  bool detect_endpoints = true;
+  uint32_t begin_color = 0x23DC82;    // 0xRRGGBB，預設和匯出的調色盤一樣
+  uint32_t end_color = 0xFA3296;
+  int32_t color_tolerance = 48;    // 每個 channel 最多差多少還算同一個顏色
+  int32_t rows_per_chunk = 64;
+};
+
+struct MazeImportResult {
+  MazeGrid grid;
+  int32_t begin_y = -1, begin_x = -1;    // 沒找到的話是 -1
+  int32_t end_y = -1, end_x = -1;
+};
+
+class MazeImage {
+public:
+  static constexpr uint64_t MAX_PNG_BYTES = uint64_t{ 1 } << 30;
+
+  static const char *extension(const ImageFormat format);
+  static bool exportGrid(const std::string &path, const MazeGrid &grid, const MazeExportOptions &options, ThreadPool &pool, const MazeOverlay *overlay = nullptr);
+  static bool importGrid(const std::string &path, const MazeImportOptions &options, ThreadPool &pool, MazeImportResult &result);
+  static bool exportHeatmap(const std::string &path, const MazeExpansionLayer &layer, const MazeGrid &grid, const MazeExportOptions &options, ThreadPool &pool);
+  static bool exportRaw(const std::string &path, const MazeExpansionLayer &layer);
+
+private:
+  using RowEncoder = std::function<void(const int32_t y0, const int32_t y1, uint8_t *out)>;
+
+  static bool writeImage(const std::string &path, const int32_t height, const int32_t width, const MazeExportOptions &options, ThreadPool &pool, const RowEncoder &encode);
+  static void encodeRows(const MazeGrid &grid, const MazeExportOptions &options, const MazeOverlay *overlay, const int32_t y0, const int32_t y1, uint8_t *out);
+  static void encodeHeatmapRows(const MazeExpansionLayer &layer, const MazeGrid &grid, const MazeExportOptions &options, const int32_t y0, const int32_t y1, uint8_t *out);
+  static void decodeRows(const uint8_t *pixels, const int32_t image_w, const MazeImportOptions &options, const int32_t y0, const int32_t y1, MazeGrid &grid, int64_t &first_begin, int64_t &first_end);
+};
+
+#endif
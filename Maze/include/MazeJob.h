@@ -0,0 +1,104 @@
+#ifndef MAZEJOB_H
+#define MAZEJOB_H
+
+/**
+ * @file MazeJob.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Background jobs for the controller actions, run one at a time and cancellable
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include "MazeAction.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+enum class JobState : int32_t {
+  PENDING,
+  RUNNING,
+  DONE,
+  CANCELLED,
+};
+
+// 已經有工作在跑的時候，新的工作怎麼處理
+enum class JobPolicy : int32_t {
+  CANCEL_PREVIOUS,    // 取消正在跑的和還在排隊的，馬上換新的
+  QUEUE,    // 排在後面，前面的跑完才輪到
+};
+
+class MazeJob {
+public:
+  using Task = std::function<void()>;
+
+  MazeJob(const uint64_t id, const MazeAction action) : job_id{ id }, job_action{ action }, job_name{ maze_action_name[static_cast<int32_t>(action)] } {}
+  MazeJob(const uint64_t id, std::string name, Task task) : job_id{ id }, job_action{ MazeAction::G_RESET }, job_name{ std::move(name) }, job_task{ std::move(task) } {}
+
+  uint64_t id() const { return job_id; }
+  MazeAction action() const { return job_action; }    // 只有 hasTask() 是 false 的工作才有意義
+  const std::string &name() const { return job_name; }
+  bool hasTask() const { return static_cast<bool>(job_task); }
+  void runTask() const { job_task(); }
+  JobState state() const { return job_state.load(); }
+  void setState(const JobState state) { job_state.store(state); }
+
+  void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+  bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+  const std::atomic<bool> *cancelToken() const { return &cancelled; }    // 給 model 和 diff queue 輪詢用
+
+private:
+  const uint64_t job_id;
+  const MazeAction job_action;
+  const std::string job_name;
+  const Task job_task;    // 不是演算法的工作 (例如存檔、讀檔)，空的話就是跑 job_action
+  std::atomic<JobState> job_state{ JobState::PENDING };
+  std::atomic<bool> cancelled{ false };
+};
+
+using MazeJobHandle = std::shared_ptr<MazeJob>;
+
+/**
+ * @brief runs submitted jobs one after another on the thread pool, so only one job ever touches the model
+ *
+ * While jobs are queued a single drain task runs them in order on one of the pool workers, then returns the worker to the pool.
+ */
+class MazeJobScheduler {
+public:
+  using JobFunction = std::function<void(MazeJob &)>;
+
+  MazeJobScheduler(ThreadPool &pool, JobFunction run_job);
+  ~MazeJobScheduler();
+
+  MazeJobScheduler(const MazeJobScheduler &) = delete;
+  MazeJobScheduler &operator=(const MazeJobScheduler &) = delete;
+
+  MazeJobHandle submit(const MazeAction action, const JobPolicy policy);
+  MazeJobHandle submit(std::string name, MazeJob::Task task, const JobPolicy policy);
+  void cancelAll();
+
+  MazeJobHandle current() const;
+  size_t pendingCount() const;
+  bool isBusy() const;
+
+private:
+  ThreadPool &pool;
+  JobFunction run_job;
+  std::deque<MazeJobHandle> pending;
+  MazeJobHandle running;
+  uint64_t next_id;
+  bool draining;    // pool 裡有一個 drain 正在跑或排隊
+  mutable std::mutex mtx;
+  std::condition_variable idle_cv;
+
+  MazeJobHandle enqueue(MazeJobHandle job, const JobPolicy policy);
+  void drain();
+};
+
+#endif
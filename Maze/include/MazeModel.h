@@ -10,13 +10,26 @@
  */
 
 #include "MazeNode.h"
-#include "MazeController.h"
+#include "MazeGrid.h"
+#include "MazeFile.h"
+#include "MazeCheckpoint.h"
+#include "MazeGrowingTree.h"
+#include "MazeDiffBatch.h"
+#include "MazeAction.h"
+#include "MazeStats.h"
+#include "IndexedHeap.h"
+#include "MazeModelListener.h"
 
 #include <vector>
 #include <memory>
 #include <utility>
 #include <mutex>
+#include <random>
+#include <optional>
+#include <string>
+#include <atomic>
 #include <cstdint>
+#include <chrono>
 
 inline constexpr int32_t MAZE_HEIGHT = 39;
 inline constexpr int32_t MAZE_WIDTH = 75;
@@ -25,56 +38,107 @@ inline constexpr int32_t BEGIN_X = 0;
 inline constexpr int32_t END_Y = MAZE_HEIGHT - 2;
 inline constexpr int32_t END_X = MAZE_WIDTH - 1;
 inline constexpr int32_t GRID_SIZE = 25;
+inline constexpr uint32_t CHECKPOINT_POLL = 1024;    // 生成演算法每幾步看一次要不要存 checkpoint
 inline constexpr std::pair<int32_t, int32_t> dir_vec[4]{ { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
 
-enum class MazeAction : int32_t {
-  G_RESET,
-  G_PRIMS,
-  G_RECURSION_BACKTRACKER,
-  G_RECURSION_DIVISION,
-  S_DFS,
-  S_BFS,
-  S_UCS_MANHATTAN,    // Cost Function 為 Two_Norm，所以距離終點越遠 Cost 越大
-  S_UCS_TWO_NORM,    // Cost Function 為 Two_Norm，所以距離終點越遠 Cost 越大
-  S_UCS_INTERVAL,    // Cost Function 以區間來計算，每一個區間 Cost 差10，距離終點越遠 Cost 越大
-  S_GREEDY,
-  S_ASTAR,
-  S_ASTAR_INTERVAL
-};
-
-class MazeController;
-
 class MazeModel {
 public:
   MazeModel(uint32_t height, uint32_t width);
-  void setController(MazeController *controller_ptr);
+  void setController(MazeModelListener *controller_ptr);
 
   void resetMaze();
   void emptyMap();
   void resetWallAroundMaze();
 
+  void setSeed(const std::optional<uint32_t> seed);
+  uint32_t lastSeed() const;
+  MazeAction lastGenerator() const;
+  MazeStats runAction(const MazeAction action);
+  void setCancelToken(const std::atomic<bool> *token);
+  void resyncView();
+
+  bool saveMaze(const std::string &path, const MazeEncoding encoding);
+  bool loadMaze(const std::string &path, const bool verify_checksum = true);
+  bool setMaze(MazeGrid grid, const int32_t begin_y = -1, const int32_t begin_x = -1, const int32_t end_y = -1, const int32_t end_x = -1);
+  void setEndpoints(const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x);
+  MazeOverlay solutionOverlay() const;
+  void setExpansionTracking(const bool enable);
+  MazeExpansionLayer expansionLayer() const;
+  bool hasExpansionLayer() const;
+
+  void setCheckpoint(const std::string &path, const double interval_seconds);
+  std::optional<MazeStats> resumeGeneration(const std::string &path);
+
   // maze generation and solving methods
-  void generateMazePrim();
-  void generateMazeRecursionBacktracker();
-  void generateMazeRecursionDivision(const int32_t uy, const int32_t lx, const int32_t dy, const int32_t rx);
+  MazeStats generateMazePrim(MazeGeneratorState *resume = nullptr);
+  MazeStats generateMazeRecursionBacktracker(MazeGeneratorState *resume = nullptr);
+  MazeStats generateMazeRecursionDivision();
+  template <typename Policy>
+  MazeStats generateMazeGrowingTree();    // 只有 runAction 用到的四種 policy 有實例化
 
-  bool solveMazeDFS(const int32_t y, const int32_t x);
-  void solveMazeBFS();
-  void solveMazeUCS(const MazeAction actions);
-  void solveMazeGreedy();
-  void solveMazeAStar(const MazeAction actions);
+  MazeStats solveMazeDFS();
+  MazeStats solveMazeBFS();
+  MazeStats solveMazeUCS(const MazeAction actions);
+  MazeStats solveMazeGreedy();
+  MazeStats solveMazeAStar(const MazeAction actions);
 
 public:
-  std::vector<std::vector<MazeElement>> maze;
+  MazeGrid maze;    // 讀檔的話直接是檔案映射出來的格子
+  int32_t height, width;
+  int32_t begin_y, begin_x;
+  int32_t end_y, end_x;
 
 private:
-  MazeController *controller_ptr;
+  MazeModelListener *controller_ptr;    // 沒有的話就不送畫面，benchmark 用
+  std::vector<uint32_t> visited;    // per-cell visit stamp, a cell is visited when its stamp equals visit_epoch
+  std::vector<uint32_t> parent;    // per-cell predecessor index of the current search, valid for visited cells
+  uint32_t visit_epoch;
+  IndexedHeap<int64_t> open_list;    // UCS / Greedy / A* 共用，每個格子最多出現一次
+  std::optional<uint32_t> fixed_seed;    // 有設定的話每次生成都用同一個種子，benchmark 用
+  uint32_t last_seed;
+  MazeAction last_generator;    // 目前這張迷宮是哪個演算法生成的，存檔用
+  MazeDiffBatch pending_diffs;    // 還沒送給畫面的 diff，滿了或這次執行結束才一次送出
+  const std::atomic<bool> *cancel_token;    // 目前工作的取消旗標，沒有的話就不會被取消
+  MazeOverlay solve_overlay;    // 上一次解法在畫面上標成 EXPLORED / PATH 的格子，下一次執行前要還原
+  std::string checkpoint_path;    // 空的代表不存 checkpoint
+  double checkpoint_seconds;
+  std::chrono::steady_clock::time_point next_checkpoint;
+  uint32_t checkpoint_tick;    // 每 CHECKPOINT_POLL 步才看一次時間
+  std::vector<uint32_t> expansion;    // per-cell expansion index of the current search, valid for visited cells
+  uint32_t expansion_count;
+  bool track_expansion;    // 要記錄的時候才配置 expansion
+  bool expansion_valid;    // 上一次搜尋之後 maze 還沒換過
 
 private:
   bool inMaze(const MazeNode &node, const int32_t delta_y, const int32_t delta_x);
   void setFlag();
 
-  void setBeginPoint(MazeNode &node);
+  std::mt19937 makeGenerator();
+  void emitNode(const MazeNode &node);
+  void emitSpan(const int32_t y, const int32_t x, const int32_t length, const MazeElement element);
+  void flushDiffs();
+  void notifyComplete();
+  bool isCancelled() const;
+  void startCheckpoint();
+  bool checkpointDue();
+  void writeCheckpoint(MazeGeneratorState &state, const MazeStats &stats, const double resumed_ms);
+  void finishCheckpoint(MazeGeneratorState &state, const MazeStats &stats, const double resumed_ms);
+
+  void setBeginPoint(MazeNode &node, std::mt19937 &gen);
+  void restoreExplored(const std::vector<MazeNode> &explored_cache);
+  void divideChamber(const int32_t uy, const int32_t lx, const int32_t dy, const int32_t rx, const uint64_t depth, std::mt19937 &gen, MazeStats &stats);
+  uint64_t tracePath(const int32_t y, const int32_t x) const;
+  void emitPath(const int32_t y, const int32_t x);
+  void emitOverlay(const int32_t y, const int32_t x, const MazeElement element);
+  void clearOverlay();
+  uint64_t searchMemory() const;
+
+  void nextVisitEpoch();
+  size_t cellIndex(const int32_t y, const int32_t x) const;
+  bool isVisited(const int32_t y, const int32_t x) const;
+  void setVisited(const int32_t y, const int32_t x, const size_t from);
+  void markExpanded(const int32_t y, const int32_t x);
+  bool isPassable(const int32_t y, const int32_t x);
   bool is_in_maze(const int32_t y, const int32_t x);
   int32_t pow_two_norm(const int32_t y, const int32_t x);
 };
@@ -0,0 +1,29 @@
+#ifndef MAZEMODELLISTENER_H
+#define MAZEMODELLISTENER_H
+
+/**
+ * @file MazeModelListener.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief What the model reports its changes to, so the model builds without the controller and the view
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * MazeController implements it for the GUI. A model without a listener (the benchmarks) runs headless and
+ * decodes files on the calling thread.
+ */
+
+#include "MazeGrid.h"
+#include "MazeDiffBatch.h"
+#include "ThreadPool.h"
+
+class MazeModelListener {
+public:
+  virtual ~MazeModelListener() = default;
+
+  virtual void setFrameMaze(const MazeGrid &maze) = 0;    // 整張圖換掉了
+  virtual void enFramequeue(const MazeDiffBatch &batch) = 0;    // 一批格子變了
+  virtual void setModelComplete() = 0;    // 這次生成或搜尋結束了
+  virtual ThreadPool &threadPool() = 0;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef MAZEMOVINGAI_H
+#define MAZEMOVINGAI_H
+
+/**
+ * @file MazeMovingAI.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Load the grid maps (.map) and scenario files (.scen) of the Moving AI pathfinding benchmarks
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * .map:  "type octile", "height H", "width W", "map", then H rows of W terrain characters.
+ *        '.' 'G' 'S' are passable, everything else ('@' 'O' 'T' 'W') becomes a wall.
+ * .scen: "version 1", then one query per line:
+ *        bucket  map  map_width  map_height  start_x  start_y  goal_x  goal_y  optimal_length
+ *
+ * The optimal length of a scenario is the octile (8-connected, no corner cutting) distance, our solvers move in
+ * 4 directions so they can never reach it. Without corner cutting both movements reach the same cells though, so
+ * every scenario is solvable here too.
+ */
+
+#include "MazeNode.h"
+#include "MazeGrid.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MazeScenario {
+  int32_t bucket = 0;
+  std::string map;    // .scen 裡寫的地圖路徑，通常是相對於 benchmark 根目錄
+  int32_t map_width = 0, map_height = 0;
+  int32_t start_y = 0, start_x = 0;
+  int32_t goal_y = 0, goal_x = 0;
+  double optimal_length = 0.0;    // octile 距離
+};
+
+class MazeMovingAI {
+public:
+  static bool isPassable(const char terrain);
+  static bool loadMap(const std::string &path, MazeGrid &grid);
+  static bool loadScenarios(const std::string &path, std::vector<MazeScenario> &scenarios);
+};
+
+#endif
@@ -11,11 +11,12 @@
 
 #include <cstdint>
 
-enum class MazeElement : int32_t {
+enum class MazeElement : int8_t {    // 一格一個 byte，大地圖的 maze 和 diff 都比較小
   INVALID = -1,
   WALL = 0,
   GROUND = 1,
   EXPLORED = 2,
+  PATH = 3,    // 解法找到的路徑，只會出現在畫面上，model 的 maze 不會有
   BEGIN = 9,
   END = 10,
 };
@@ -0,0 +1,62 @@
+#ifndef MAZEOUTOFCORE_H
+#define MAZEOUTOFCORE_H
+
+/**
+ * @file MazeOutOfCore.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Generators and solvers that run on a MazeTiledGrid, for mazes larger than memory
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * Nothing here keeps a per-cell array in memory. The backtracker and the solvers remember how every cell was reached
+ * as one direction byte per cell in a tiled scratch file, the backtracker walks back through it instead of keeping a
+ * stack, and the solvers trace their path through it. Eller's algorithm needs only a few arrays of one maze row. What
+ * stays in memory is the resident tiles of both files, the open list of the solvers and O(width) for Eller.
+ *
+ * The mazes have the same layout as the ones MazeModel generates: cells on odd coordinates, begin at (1, 0) and end at
+ * (height - 2, width - 1) unless moved.
+ */
+
+#include "MazeNode.h"
+#include "MazeStats.h"
+#include "MazeTiledGrid.h"
+
+#include <cstdint>
+#include <string>
+
+class MazeOutOfCore {
+public:
+  /**
+   * @param scratch_path file for the direction bytes, created for every run and removed after it
+   * @param scratch_resident_bytes resident limit of the scratch file
+   */
+  MazeOutOfCore(MazeTiledGrid &grid, std::string scratch_path, const size_t scratch_resident_bytes);
+
+  void setEndpoints(const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x);
+
+  MazeStats generateBacktracker(const uint32_t seed);
+  MazeStats generateEller(const uint32_t seed);
+  MazeStats solveBFS();
+  MazeStats solveAStar();
+
+  const MazeTileStats &scratchStats() const { return from.stats(); }    // 上一次執行的 scratch 檔
+
+  int32_t begin_y, begin_x;
+  int32_t end_y, end_x;
+
+private:
+  MazeTiledGrid &grid;
+  std::string scratch_path;
+  size_t scratch_resident_bytes;
+  MazeTiledArray<uint8_t> from;    // 0 還沒走過，1 ~ 4 是從哪個方向走過來的，ORIGIN 是起點
+
+  bool openScratch(const int32_t height, const int32_t width);
+  void closeScratch();
+  void fillWalls();
+  void setFlag();
+  bool isPassable(const int32_t y, const int32_t x);
+  uint64_t tracePath();
+  uint64_t residentBytes() const;
+};
+
+#endif
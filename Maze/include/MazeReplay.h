@@ -0,0 +1,87 @@
+#ifndef MAZEREPLAY_H
+#define MAZEREPLAY_H
+
+/**
+ * @file MazeReplay.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Record the diff stream of a run to disk with periodic keyframes, and seek to any point of it
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * File layout (little endian):
+ *   header   "MZRP", uint32 version, int32 height, int32 width
+ *   records  uint8 type, then
+ *            KEYFRAME: uint64 position, height * width element bytes
+ *            BATCH:    uint32 cell_count, uint32 span_count, cell indices, cell elements, span begins, span lengths, span elements
+ *            END:      nothing
+ *   footer   uint32 seed, int32 algorithm, uint64 diff count, uint64 keyframe count,
+ *            (uint64 position, uint64 file offset) per keyframe, uint64 footer offset, "MZRE"
+ *
+ * A position counts diffs the same way the view does, one per cell and one per row span.
+ */
+
+#include "MazeNode.h"
+#include "MazeAction.h"
+#include "MazeDiffBatch.h"
+#include "MazeGrid.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class MazeReplayWriter {
+public:
+  bool open(const std::string &path, const int32_t height, const int32_t width, const MazeAction action, const MazeGrid &maze);
+  bool isOpen() const { return os.is_open(); }
+
+  void recordFrame(const MazeGrid &maze);
+  void recordBatch(const MazeDiffBatch &batch);
+  bool close(const uint32_t seed);
+
+private:
+  struct Keyframe {
+    uint64_t position, offset;
+  };
+
+  std::ofstream os;
+  int32_t height = 0, width = 0;
+  MazeAction action = MazeAction::G_RESET;
+  std::vector<MazeElement> shadow;    // 目前畫面該有的樣子，週期性的 keyframe 從這裡寫
+  std::vector<Keyframe> keyframes;
+  uint64_t position = 0;
+  uint64_t last_keyframe = 0;
+  uint64_t keyframe_interval = 0;    // 每隔這麼多個 diff 寫一張 keyframe
+
+  void writeKeyframe();
+};
+
+class MazeReplayReader {
+public:
+  bool open(const std::string &path);
+  bool isOpen() const { return is.is_open(); }
+  void close() { is.close(); }
+
+  int32_t height() const { return grid_height; }
+  int32_t width() const { return grid_width; }
+  uint32_t seed() const { return run_seed; }
+  MazeAction action() const { return run_action; }
+  uint64_t diffCount() const { return diff_count; }
+
+  bool seek(const uint64_t target, MazeGrid &maze);
+
+private:
+  struct Keyframe {
+    uint64_t position, offset;
+  };
+
+  std::ifstream is;
+  int32_t grid_height = 0, grid_width = 0;
+  uint32_t run_seed = 0;
+  MazeAction run_action = MazeAction::G_RESET;
+  uint64_t diff_count = 0;
+  std::vector<Keyframe> keyframes;
+  MazeDiffBatch batch;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef MAZESHAREDGRID_H
+#define MAZESHAREDGRID_H
+
+/**
+ * @file MazeSharedGrid.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Publish the live grid in a POSIX shared-memory segment, other processes read consistent snapshots through a seqlock
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * Segment layout (native endian, shm_open name such as "/maze_grid"):
+ *   header  MazeSharedHeader, HEADER_BYTES bytes
+ *   cells   capacity bytes, the first height * width of them are the grid, one MazeElement per cell, row-major
+ *
+ * There is one writer. It makes sequence odd, writes the cells and the shape, then makes it even again and bumps
+ * version. A reader copies the shape and the cells between two reads of sequence and keeps the copy only if both
+ * reads saw the same even value, otherwise it retries. Nobody waits on anybody: the writer never blocks, a reader
+ * only retries while a write overlaps its copy.
+ *
+ * The segment grows (ftruncate) when a larger grid is published, capacity tells readers to map it again. The cells
+ * are copied with memcpy on both sides, the sequence check is what makes a torn copy impossible to keep.
+ *
+ * MazeSharedPublisher sits on the diff stream of the controller, keeps the grid the view is showing and publishes
+ * only the rows that changed, at most once per interval, so a reader copying a huge grid is not starved by a writer
+ * publishing every batch.
+ */
+
+#include "MazeNode.h"
+#include "MazeGrid.h"
+#include "MazeDiffBatch.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct MazeSharedHeader {
+  char magic[4];    // "MZSH"
+  uint32_t layout;    // MazeSharedGrid::LAYOUT
+  std::atomic<uint64_t> sequence;    // seqlock，奇數代表 writer 正在寫
+  std::atomic<uint64_t> version;    // 每發布一次加一
+  std::atomic<uint64_t> capacity;    // cells 區有幾個 byte
+  std::atomic<int32_t> height;
+  std::atomic<int32_t> width;
+};
+
+class MazeSharedGrid {
+public:
+  static constexpr uint32_t LAYOUT = 1;
+  static constexpr size_t HEADER_BYTES = 64;
+  static constexpr const char *DEFAULT_NAME = "/maze_grid";
+
+  MazeSharedGrid() = default;
+  MazeSharedGrid(const MazeSharedGrid &) = delete;
+  MazeSharedGrid &operator=(const MazeSharedGrid &) = delete;
+  ~MazeSharedGrid();
+
+  bool create(const std::string &name, const int32_t height, const int32_t width);
+  bool open(const std::string &name);
+  void close();
+  bool isOpen() const { return header != nullptr; }
+
+  // writer
+  bool publish(const MazeGrid &grid);
+  bool publishRows(const MazeGrid &grid, const int32_t y0, const int32_t y1);
+
+  // reader
+  bool snapshot(MazeGrid &grid, uint64_t &version, const uint32_t max_attempts = 1000);
+  uint64_t version() const;
+  uint64_t retries() const { return retry_count; }    // 讀到一半被寫入，重來的次數
+
+private:
+  std::string name;
+  int fd = -1;
+  bool writer = false;
+  MazeSharedHeader *header = nullptr;
+  uint8_t *cells = nullptr;
+  size_t mapped_bytes = 0;
+  uint64_t retry_count = 0;
+
+  bool map(const size_t bytes);
+  void unmap();
+  bool reserve(const size_t cell_bytes);
+  void beginWrite();
+  void endWrite();
+};
+
+class MazeSharedPublisher {
+public:
+  static constexpr double DEFAULT_INTERVAL_MS = 16.0;
+
+  bool open(const std::string &name, const MazeGrid &maze, const double interval_ms = DEFAULT_INTERVAL_MS);
+  void close();
+  bool isOpen() const { return shared.isOpen(); }
+
+  void recordFrame(const MazeGrid &maze);
+  void recordBatch(const MazeDiffBatch &batch);
+  void flush();
+
+private:
+  MazeSharedGrid shared;
+  MazeGrid shadow;    // 畫面目前的樣子，套用每一批 diff
+  int32_t dirty_y0 = 0, dirty_y1 = 0;    // 還沒發布的列 [dirty_y0, dirty_y1)
+  bool reshaped = false;    // 大小變了，下一次整張發布
+  std::chrono::steady_clock::duration interval{};
+  std::chrono::steady_clock::time_point last_publish{};
+
+  void markRows(const int32_t y0, const int32_t y1);
+  void maybeFlush();
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MAZESTATS_H
+#define MAZESTATS_H
+
+/**
+ * @file MazeStats.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Counters recorded by every maze generator and solver
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+struct MazeStats {
+  uint64_t nodes_expanded = 0;    // 生成時是打通的格子數，解迷宮時是展開的節點數
+  uint64_t pushes = 0;
+  uint64_t pops = 0;
+  uint64_t peak_open = 0;    // open list (queue / stack / candidate list) 的最大長度
+  uint64_t peak_memory = 0;    // 演算法工作資料的最大用量 (bytes)
+  uint64_t path_length = 0;    // 起點到終點的步數，沒找到就是 0
+  double elapsed_ms = 0.0;
+
+  void start() { start_time = std::chrono::steady_clock::now(); }
+  void stop() { elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count(); }
+
+  /**
+   * @brief record the current size of the open list and the working memory it implies
+   *
+   * @param open_size number of entries in the open list
+   * @param entry_bytes size of one open list entry
+   * @param fixed_bytes memory that does not depend on the open list (visited / parent arrays, caches)
+   */
+  void trackOpen(const uint64_t open_size, const uint64_t entry_bytes, const uint64_t fixed_bytes)
+  {
+    peak_open = std::max(peak_open, open_size);
+    peak_memory = std::max(peak_memory, open_size * entry_bytes + fixed_bytes);
+  }
+
+private:
+  std::chrono::steady_clock::time_point start_time;
+};
+
+#endif
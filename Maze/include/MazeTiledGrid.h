@@ -0,0 +1,173 @@
+#ifndef MAZETILEDGRID_H
+#define MAZETILEDGRID_H
+
+/**
+ * @file MazeTiledGrid.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Grid stored as fixed-size square tiles in a file, only the most recently used tiles are mapped
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * File layout:
+ *   header  one 4096 byte page, "MZTL", uint32 version, int32 height, int32 width, uint32 tile_shift, uint32 element_bytes
+ *   tiles   (2^tile_shift)^2 elements each, row-major inside the tile, tiles row-major over the grid,
+ *           the last tile row / column is padded to a whole tile
+ *
+ * A new file is sized with ftruncate, so tiles that were never written cost no disk and read as zero
+ * (MazeElement::WALL). Every tile is mapped on its own (MAP_SHARED), a fault maps the tile and unmaps the least recently
+ * used one once the resident limit is reached; changes go back to the file through the page cache. Platforms without
+ * mmap read tiles into buffers and write them back on eviction.
+ *
+ * grid[y][x] works like on MazeGrid, but the reference is only valid until the next access of another tile, which may
+ * evict it. Read or write one cell per expression.
+ */
+
+#include "MazeNode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#endif
+
+struct MazeTileStats {
+  uint64_t hits = 0;    // 存取的格子所在的 tile 已經在記憶體裡
+  uint64_t faults = 0;    // 要先把 tile 映射進來
+  uint64_t evictions = 0;
+  uint64_t resident_tiles = 0, peak_resident_tiles = 0;
+  uint64_t tile_bytes = 0;
+};
+
+/**
+ * @brief the file and the LRU of mapped tiles, in bytes, MazeTiledArray puts the element type on top
+ */
+class MazeTileCache {
+public:
+  static constexpr size_t HEADER_BYTES = 4096;
+  static constexpr size_t MIN_RESIDENT_TILES = 4;    // 一格和上下左右的鄰居最多跨 3 個 tile
+
+  MazeTileCache() = default;
+  MazeTileCache(const MazeTileCache &) = delete;
+  MazeTileCache &operator=(const MazeTileCache &) = delete;
+  ~MazeTileCache() { close(); }
+
+  bool create(const std::string &path, const int32_t height, const int32_t width, const uint32_t element_bytes, const uint32_t tile_shift, const size_t resident_bytes);
+  bool open(const std::string &path, const uint32_t element_bytes, const size_t resident_bytes);
+  void close();
+  bool isOpen() const { return is_open; }
+
+  void setResidentLimit(const size_t bytes);
+  size_t residentLimit() const { return max_tiles * tile_bytes; }
+
+  int32_t height() const { return grid_height; }
+  int32_t width() const { return grid_width; }
+  uint32_t tileShift() const { return tile_shift; }
+  size_t tileColumns() const { return tile_cols; }
+  const MazeTileStats &stats() const { return tile_stats; }
+  void resetStats();
+
+  /**
+   * @brief the bytes of tile index, mapping it when it is not resident, throws std::bad_alloc when it cannot be mapped
+   */
+  uint8_t *tile(const size_t index)
+  {
+    if (index == last_tile) {
+      ++tile_stats.hits;
+      return last_data;
+    }
+    return lookup(index);
+  }
+
+private:
+  struct Slot {
+    size_t tile = 0;
+    uint8_t *data = nullptr;
+#if defined(_WIN32)
+    std::vector<uint8_t> buffer;
+#endif
+  };
+
+  uint8_t *lookup(const size_t index);
+  bool mapTile(Slot &slot);
+  void unmapTile(Slot &slot);
+  bool openFile(const std::string &path, const bool truncate);
+  void setLayout(const int32_t height, const int32_t width, const uint32_t element_bytes, const uint32_t tile_shift);
+
+  std::list<Slot> lru;    // 最前面是最近用過的
+  std::unordered_map<size_t, std::list<Slot>::iterator> resident;
+  size_t last_tile = SIZE_MAX;    // 上一次存取的 tile，連續存取同一個 tile 不用查表
+  uint8_t *last_data = nullptr;
+
+  bool is_open = false;
+#if defined(_WIN32)
+  std::fstream file;
+#else
+  int fd = -1;
+#endif
+  int32_t grid_height = 0, grid_width = 0;
+  uint32_t tile_shift = 0;
+  size_t tile_rows = 0, tile_cols = 0, tile_bytes = 0;
+  size_t max_tiles = MIN_RESIDENT_TILES;
+  MazeTileStats tile_stats;
+};
+
+template <typename T>
+class MazeTiledArray {
+public:
+  static constexpr uint32_t DEFAULT_TILE_SHIFT = 8;    // 256 x 256 格一個 tile
+
+  class Row {
+  public:
+    Row(MazeTiledArray *array, const int32_t y) : array{ array }, y{ y } {}
+    T &operator[](const int32_t x) const { return array->at(y, x); }
+
+  private:
+    MazeTiledArray *array;
+    int32_t y;
+  };
+
+  /**
+   * @brief new zero-filled array at path, replacing the file
+   *
+   * @param resident_bytes how much of it may be mapped at once, at least MIN_RESIDENT_TILES tiles
+   */
+  bool create(const std::string &path, const int32_t height, const int32_t width, const size_t resident_bytes, const uint32_t tile_shift = DEFAULT_TILE_SHIFT)
+  {
+    return cache.create(path, height, width, sizeof(T), tile_shift, resident_bytes);
+  }
+  bool open(const std::string &path, const size_t resident_bytes) { return cache.open(path, sizeof(T), resident_bytes); }
+  void close() { cache.close(); }
+  bool isOpen() const { return cache.isOpen(); }
+
+  int32_t height() const { return cache.height(); }
+  int32_t width() const { return cache.width(); }
+  int32_t tileSide() const { return int32_t{ 1 } << cache.tileShift(); }
+  size_t size() const { return static_cast<size_t>(height()) * width(); }
+  void setResidentLimit(const size_t bytes) { cache.setResidentLimit(bytes); }
+  size_t residentLimit() const { return cache.residentLimit(); }
+  const MazeTileStats &stats() const { return cache.stats(); }
+  void resetStats() { cache.resetStats(); }
+
+  T &at(const int32_t y, const int32_t x)
+  {
+    const uint32_t shift = cache.tileShift();
+    const uint32_t mask = (1u << shift) - 1;
+    const size_t tile = (static_cast<size_t>(y) >> shift) * cache.tileColumns() + (static_cast<size_t>(x) >> shift);
+    T *cells = reinterpret_cast<T *>(cache.tile(tile));
+    return cells[((static_cast<size_t>(y) & mask) << shift) + (static_cast<size_t>(x) & mask)];
+  }
+
+  Row operator[](const int32_t y) { return Row(this, y); }
+
+private:
+  MazeTileCache cache;
+};
+
+using MazeTiledGrid = MazeTiledArray<MazeElement>;
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MAZETRACE_H
+#define MAZETRACE_H
+
+/**
+ * @file MazeTrace.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Scoped trace events written in the Chrome trace JSON format (chrome://tracing, ui.perfetto.dev)
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * Every thread keeps at most MAX_EVENTS_PER_THREAD events. Past that its oldest ones are overwritten, so a long
+ * session keeps the recent history in bounded memory, and the saved file reports how many were dropped.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MazeTrace {
+public:
+  static constexpr size_t MAX_EVENTS_PER_THREAD = size_t{ 1 } << 18;    // 一個 event 24 byte，每個 thread 最多 6 MiB
+
+  static void setEnabled(const bool enable);
+  static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  static int64_t now();    // microseconds since the first trace call
+  static void record(const char *name, const int64_t begin_us, const int64_t end_us);
+  static void setThreadName(const char *name);
+
+  static bool save(const std::string &path);
+  static void clear();
+  static uint64_t droppedEvents();    // 所有 thread 被蓋掉的 event 數
+
+private:
+  static std::atomic<bool> enabled;
+};
+
+/**
+ * @brief RAII trace event, only touches the clock when tracing is enabled
+ */
+class MazeTraceScope {
+public:
+  explicit MazeTraceScope(const char *name)
+      : name{ name }, begin_us{ MazeTrace::isEnabled() ? MazeTrace::now() : -1 } {}
+  ~MazeTraceScope()
+  {
+    if (begin_us >= 0) MazeTrace::record(name, begin_us, MazeTrace::now());
+  }
+
+  MazeTraceScope(const MazeTraceScope &) = delete;
+  MazeTraceScope &operator=(const MazeTraceScope &) = delete;
+
+private:
+  const char *name;
+  int64_t begin_us;
+};
+
+#define MAZE_TRACE_CONCAT_IMPL(a, b) a##b
+#define MAZE_TRACE_CONCAT(a, b) MAZE_TRACE_CONCAT_IMPL(a, b)
+#define MAZE_TRACE_SCOPE(name) MazeTraceScope MAZE_TRACE_CONCAT(maze_trace_scope_, __LINE__)(name)
+
+#endif
@@ -11,33 +11,117 @@
 
 #include "MazeController.h"
 #include "MazeNode.h"
-#include "ThreadSafeQueue.h"
+#include "MazeDiffBatch.h"
+#include "MazeReplay.h"
+#include "MazeImage.h"
+#include "SpscRingBuffer.h"
 #include "imgui_impl_glfw.h"
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 class MazeController;
 struct MazeNode;
 
+// 每一幀要從 diff queue 拿多少東西出來畫
+enum class PlaybackMode : int32_t {
+  DIFFS_PER_FRAME,    // 固定 N 個
+  TIME_BUDGET,    // 在時間預算內能拿多少就拿多少
+  INSTANT,    // 直接套用到最新的狀態
+};
+
 class MazeView {
 public:
+  static constexpr size_t DIFF_QUEUE_CAPACITY = 256;    // 幾批，generator 超過這麼多批沒畫的 diff 就會等畫面
+  static constexpr size_t DIFF_CHUNK_SIZE = 64;    // deFramequeue 每套用這麼多個 diff 看一次時間
+  static constexpr int32_t TILE_SIZE = 64;    // dirty 追蹤和上傳 texture 的單位，TILE_SIZE x TILE_SIZE 格
+  static constexpr float DEFAULT_CELL_SIZE = 15.0f;    // 一格幾個 pixel
+  static constexpr float MAX_CELL_SIZE = 64.0f;
+  static constexpr size_t PARALLEL_PYRAMID_TEXELS = size_t{ 1 } << 16;    // 一層要重算超過這麼多個 texel 就分給 thread pool
+  static constexpr int32_t HEATMAP_BINS = 256;    // heatmap 每一邊最多畫幾格，放大縮小的時候換 pyramid 的層
+  static constexpr int32_t HEATMAP_COLORS = 64;    // 第 0 個是透明的，給沒有展開的格子
+
+
   MazeView(uint32_t height, uint32_t width);
   void setController(MazeController *controller_ptr);
 
   void render(GLFWwindow *);
   void renderGUI();
-  void setFrameMaze(const std::vector<std::vector<MazeElement>> &maze);
-  void enFramequeue(const MazeNode &node);
+  bool setFrameMaze(const MazeGrid &maze, const std::atomic<bool> *cancel = nullptr);
+  bool enFramequeue(const MazeDiffBatch &batch, const std::atomic<bool> *cancel = nullptr);
 
 private:
-  std::vector<std::vector<MazeElement>> render_maze;
+  MazeGrid render_maze;
   MazeController *controller_ptr;
-  ThreadSafeQueue<MazeNode> MazeDiffQueue;
+  SpscRingBuffer<MazeDiffBatch> MazeDiffQueue;    // producer 只能是 model 的工作 thread，consumer 只能是 UI thread
+  MazeDiffBatch current_batch;    // 正在套用的那一批，一幀可能只套用其中一部分
+  uint32_t batch_span_pos, batch_cell_pos;    // current_batch 下一個要套用的 span / cell
+  std::atomic<bool> batch_in_progress;    // current_batch 還沒套用完，setFrameMaze 要等它
   MazeNode update_node;
   bool stop_flag;
+  bool trace_flag;
+  PlaybackMode playback_mode;
+  int32_t diffs_per_frame;
+  float frame_budget_ms;
   std::mutex maze_mutex;
+  int32_t stats_metric;    // 統計圖表目前顯示的欄位
+  uint32_t maze_texture;    // GL texture name, 一個 texel 對應一格
+  int32_t tile_rows, tile_cols;
+  std::vector<uint64_t> dirty_tiles;    // 每個 tile 一個 bit，還沒上傳到 texture 的 tile
+  std::vector<uint32_t> upload_buffer;    // 上傳用的 RGBA8 暫存
+  std::vector<std::vector<uint32_t>> pyramid;    // pyramid[k] 是第 k + 1 層，每個 texel 是下一層 2x2 的平均顏色
+  float zoom;    // 一格幾個 pixel
+  float pan_y, pan_x;    // 畫面左上角對到的格子座標
+  bool fit_request;    // 下一幀把整個迷宮縮放到畫面裡
+  int32_t window_level, window_y, window_x, window_h, window_w;    // texture 目前放的是第幾層的哪一塊，level -1 代表還沒放
+  int32_t texture_h, texture_w;    // texture 配置的大小，可能比 window 大
+  bool record_flag;
+  bool replay_mode;    // 畫面顯示的是錄下來的紀錄，不是 model 目前的狀態
+  bool replay_playing;
+  uint64_t replay_position;
+  MazeReplayReader replay;
+  MazeGrid replay_maze;    // seek 出來的那一格時間點
+  MazeGrid live_maze;    // 開啟紀錄前的畫面，關掉之後還原
+  MazeExportOptions export_options;
+  bool export_solution;    // 匯出的圖要不要畫上最後一次的解法
+  MazeImportOptions import_options;
+  bool heatmap_flag;
+  std::shared_ptr<const MazeExpansionLayer> heatmap_layer;
+  uint64_t heatmap_version;
+  std::vector<std::vector<uint32_t>> heatmap_pyramid;    // heatmap_pyramid[k] 是第 k + 1 層，每個 texel 是下一層 2x2 裡最早的展開順序
+  std::vector<float> heatmap_bins;    // 目前畫面上的那一塊，已經換算成 colormap 的位置
+  std::array<int32_t, 5> heatmap_window;    // heatmap_bins 是哪一層的哪一塊，level -1 代表要重算
+  int32_t heatmap_colormap;
 
 private:
   void deFramequeue();
+  void copyFrame(const MazeGrid &maze);
+  void resizeTiles();
+  void renderReplay();
+  void renderJobs();
+  void renderExport();
+  void showReplay(const uint64_t position);
+  size_t applyBatch(const size_t max_count);
   void renderMaze();
+  void markDirty(const int32_t y, const int32_t x);
+  void markAllDirty();
+  void buildPyramid();
+  void updatePyramid(int32_t y0, int32_t x0, int32_t y1, int32_t x1);
+  int32_t levelHeight(const int32_t level) const;
+  int32_t levelWidth(const int32_t level) const;
+  uint32_t levelColor(const int32_t level, const int32_t y, const int32_t x) const;
+  void handleViewportInput(const ImVec2 &origin, const ImVec2 &view_size);
+  void uploadWindow(const int32_t level, const int32_t win_y, const int32_t win_x, const int32_t win_h, const int32_t win_w);
+  void releaseTexture();
+  void renderStats();
+  void renderHeatmapControls();
+  void updateHeatmap();
+  void buildHeatmapPyramid();
+  uint32_t heatmapOrder(const int32_t level, const int32_t y, const int32_t x) const;
+  void renderHeatmap(const ImVec2 &origin, const ImVec2 &view_size, const int32_t cell_y0, const int32_t cell_x0, const int32_t cell_y1, const int32_t cell_x1);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+/**
+ * @file SpscRingBuffer.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief The diff queue between the thread that runs the model and the render thread
+ * @version 0.1
+ * @date 2024-09-22
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief bounded lock-free ring buffer for exactly one producer thread and one consumer thread
+ *
+ * The capacity is rounded up to a power of two. The head (consumer) and tail (producer) indices live on
+ * their own cache lines, and each side keeps a cached copy of the other side's index, so the shared
+ * atomics are only read when the cached value says the buffer looks full (or empty).
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+  explicit SpscRingBuffer(const size_t capacity)
+  {
+    size_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    buffer.resize(rounded);
+    mask = rounded - 1;
+  }
+
+  SpscRingBuffer(const SpscRingBuffer &) = delete;
+  SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+  /* -------------------- producer side -------------------- */
+
+  bool tryPush(const T &value)
+  {
+    const size_t tail = tail_index.load(std::memory_order_relaxed);
+    if (tail - cached_head > mask) {
+      cached_head = head_index.load(std::memory_order_acquire);
+      if (tail - cached_head > mask)
+        return false;
+    }
+
+    buffer[tail & mask] = value;
+    tail_index.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 放不下的時候讓出 CPU 等 consumer，generator 就會被畫面的速度擋住
+  void push(const T &value)
+  {
+    while (!tryPush(value))
+      std::this_thread::yield();
+  }
+
+  /**
+   * @brief push as many values as fit, publishing them with a single release store
+   *
+   * @return number of values pushed
+   */
+  size_t tryPushBatch(const T *values, const size_t count)
+  {
+    const size_t tail = tail_index.load(std::memory_order_relaxed);
+    size_t free_slots = buffer.size() - (tail - cached_head);
+    if (free_slots < count) {
+      cached_head = head_index.load(std::memory_order_acquire);
+      free_slots = buffer.size() - (tail - cached_head);
+    }
+
+    const size_t n = std::min(free_slots, count);
+    for (size_t i = 0; i < n; ++i)
+      buffer[(tail + i) & mask] = values[i];
+    tail_index.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  void pushBatch(const T *values, size_t count)
+  {
+    while (count > 0) {
+      const size_t n = tryPushBatch(values, count);
+      values += n;
+      count -= n;
+      if (count > 0)
+        std::this_thread::yield();
+    }
+  }
+
+  /* -------------------- consumer side -------------------- */
+
+  std::optional<T> tryPop()
+  {
+    const size_t head = head_index.load(std::memory_order_relaxed);
+    if (head == cached_tail) {
+      cached_tail = tail_index.load(std::memory_order_acquire);
+      if (head == cached_tail)
+        return std::nullopt;
+    }
+
+    T value = buffer[head & mask];
+    head_index.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  /**
+   * @brief pop up to max_count values into out, releasing the slots with a single store
+   *
+   * @return number of values popped
+   */
+  size_t popBatch(T *out, const size_t max_count)
+  {
+    const size_t head = head_index.load(std::memory_order_relaxed);
+    if (cached_tail - head < max_count)
+      cached_tail = tail_index.load(std::memory_order_acquire);
+
+    const size_t n = std::min(cached_tail - head, max_count);
+    for (size_t i = 0; i < n; ++i)
+      out[i] = buffer[(head + i) & mask];
+    head_index.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /* -------------------- either side -------------------- */
+
+  // 另一邊還在動的話只是個近似值
+  size_t size() const { return tail_index.load(std::memory_order_acquire) - head_index.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return buffer.size(); }
+
+private:
+  static constexpr size_t CACHE_LINE = 64;
+
+  alignas(CACHE_LINE) std::atomic<size_t> head_index{ 0 };    // 下一個要讀的位置，只有 consumer 會寫
+  size_t cached_tail = 0;    // consumer 看到的 tail
+  alignas(CACHE_LINE) std::atomic<size_t> tail_index{ 0 };    // 下一個要寫的位置，只有 producer 會寫
+  size_t cached_head = 0;    // producer 看到的 head
+  alignas(CACHE_LINE) std::vector<T> buffer;
+  size_t mask;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/**
+ * @file ThreadPool.h
+ * @author Mes (mes900903@gmail.com)
+ * @brief Fixed set of worker threads with per-worker deques and work stealing, shared by every background feature
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * A worker pushes and pops its own deque at the back (newest first, still warm in cache) and steals from the
+ * front of the others. Threads outside the pool push to a shared injection queue. A worker waiting on pool work
+ * runs queued tasks while it waits, so a job waiting on its own subtasks never deadlocks even with a single worker.
+ * Threads outside the pool (the UI thread) only yield while waiting, they never pick up someone else's job.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * @param worker_count 0 means one worker per hardware thread
+   * @param pin_workers pin worker i to CPU i (modulo the CPU count), only supported on Linux
+   */
+  explicit ThreadPool(const size_t worker_count = 0, const bool pin_workers = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t size() const { return workers.size(); }
+  bool isPinned() const { return pinned; }
+  bool isWorkerThread() const;
+
+  void post(Task task);
+
+  /**
+   * @brief queue a callable and get its result through a future
+   */
+  template <typename F>
+  auto submit(F &&fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+  {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+    std::future<Result> result = task->get_future();
+    post([task] { (*task)(); });
+    return result;
+  }
+
+  /**
+   * @brief block until pred() is true, a worker runs queued tasks in the meantime instead of sleeping
+   */
+  template <typename Pred>
+  void waitUntil(Pred pred)
+  {
+    const bool help = isWorkerThread();
+    while (!pred())
+      if (!help || !runPending())
+        std::this_thread::yield();
+  }
+
+  template <typename T>
+  T wait(std::future<T> &result)
+  {
+    waitUntil([&] { return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+    return result.get();
+  }
+
+  void parallelFor(const size_t begin, const size_t end, const size_t grain, const std::function<void(size_t, size_t)> &body);
+
+  bool runPending();
+
+private:
+  struct Worker {
+    std::deque<Task> tasks;
+    std::mutex mtx;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::deque<Task> injection;    // 從 pool 外面丟進來的工作
+  std::mutex mtx;    // 保護 injection 和 stopping，也是睡覺用的鎖
+  std::condition_variable cv;
+  std::atomic<size_t> queued;    // 所有 deque 裡的工作總數，worker 用來判斷要不要睡
+  bool stopping;
+  bool pinned;
+
+  bool popTask(const size_t self, Task &task);
+  void workerLoop(const size_t index);
+};
+
+#endif
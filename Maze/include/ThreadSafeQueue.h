@@ -32,6 +32,12 @@ public:
     return queue_.empty();
   }
 
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return queue_.size();
+  }
+
 private:
   std::queue<T> queue_;
   mutable std::mutex mtx_;
@@ -0,0 +1,229 @@
+#include "MazeCheckpoint.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+  constexpr char CHECKPOINT_MAGIC[4]{ 'M', 'Z', 'C', 'K' };
+  constexpr char CHECKPOINT_END[4]{ 'M', 'Z', 'C', 'E' };
+  constexpr uint64_t MAX_RNG_TEXT = 1 << 16;    // mt19937 的文字狀態大約 7 KB
+  constexpr size_t NODE_BYTES = 9;
+  constexpr size_t FRAME_BYTES = NODE_BYTES + 5;
+
+  template <typename T>
+  void put(std::ostream &os, const T &value)
+  {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  bool get(std::istream &is, T &value)
+  {
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(&value), sizeof(value)));
+  }
+
+  uint8_t *putNode(uint8_t *out, const MazeNode &node)
+  {
+    std::memcpy(out, &node.y, 4);
+    std::memcpy(out + 4, &node.x, 4);
+    out[8] = static_cast<uint8_t>(node.element);
+    return out + NODE_BYTES;
+  }
+
+  const uint8_t *getNode(const uint8_t *in, MazeNode &node)
+  {
+    std::memcpy(&node.y, in, 4);
+    std::memcpy(&node.x, in + 4, 4);
+    node.element = static_cast<MazeElement>(in[8]);
+    return in + NODE_BYTES;
+  }
+
+  void putNodes(std::ostream &os, const std::vector<MazeNode> &nodes)
+  {
+    put<uint64_t>(os, nodes.size());
+    std::vector<uint8_t> buffer(nodes.size() * NODE_BYTES);
+    uint8_t *out = buffer.data();
+    for (const MazeNode &node : nodes)
+      out = putNode(out, node);
+    os.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+  }
+
+  // 檔案從目前位置到 file_size 還剩幾個 byte
+  uint64_t remaining(std::istream &is, const uint64_t file_size)
+  {
+    const std::streamoff position = is.tellg();
+    return position < 0 || static_cast<uint64_t>(position) > file_size ? 0 : file_size - static_cast<uint64_t>(position);
+  }
+
+  /**
+   * @brief read count records, refusing counts that cannot fit in the rest of a maze of cells cells or of the file
+   */
+  bool getNodes(std::istream &is, const uint64_t cells, const uint64_t file_size, std::vector<MazeNode> &nodes)
+  {
+    uint64_t count;
+    if (!get(is, count) || count > 4 * cells || count > remaining(is, file_size) / NODE_BYTES)
+      return false;
+    std::vector<uint8_t> buffer(count * NODE_BYTES);
+    if (!is.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+      return false;
+    nodes.resize(count);
+    const uint8_t *in = buffer.data();
+    for (MazeNode &node : nodes)
+      in = getNode(in, node);
+    return true;
+  }
+}    // namespace
+
+/**
+ * @brief write state and the grid it is working on
+ *
+ * @param stats the counters of the run so far, elapsed_ms included
+ */
+bool MazeCheckpoint::save(const std::string &path, const MazeGeneratorState &state, const MazeStats &stats, const MazeGrid &maze,
+                          const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x)
+{
+  MAZE_TRACE_SCOPE("MazeCheckpoint::save");
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream os(temp_path, std::ios::binary | std::ios::trunc);
+    if (!os)
+      return false;
+
+    os.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(os, VERSION);
+    put(os, static_cast<int32_t>(state.algorithm));
+    put(os, state.seed);
+    put(os, maze.height());
+    put(os, maze.width());
+    put(os, begin_y), put(os, begin_x), put(os, end_y), put(os, end_x);
+    put(os, stats.nodes_expanded), put(os, stats.pushes), put(os, stats.pops);
+    put(os, stats.peak_open), put(os, stats.peak_memory), put(os, stats.path_length);
+    put(os, stats.elapsed_ms);
+    for (const int32_t dir : state.direction_order)
+      put(os, dir);
+
+    std::ostringstream rng;
+    rng << state.gen;
+    const std::string rng_text = rng.str();
+    put<uint64_t>(os, rng_text.size());
+    os.write(rng_text.data(), static_cast<std::streamsize>(rng_text.size()));
+
+    putNodes(os, state.explored_cache);
+    putNodes(os, state.frontier);
+
+    put<uint64_t>(os, state.stack.size());
+    std::vector<uint8_t> frames(state.stack.size() * FRAME_BYTES);
+    uint8_t *out = frames.data();
+    for (const MazeTraceFrame &frame : state.stack) {
+      out = putNode(out, frame.node);
+      *out++ = static_cast<uint8_t>(frame.index);
+      out = std::copy(frame.direction_order.begin(), frame.direction_order.end(), out);
+    }
+    os.write(reinterpret_cast<const char *>(frames.data()), static_cast<std::streamsize>(frames.size()));
+
+    os.write(reinterpret_cast<const char *>(maze.data()), static_cast<std::streamsize>(maze.size()));
+    os.write(CHECKPOINT_END, sizeof(CHECKPOINT_END));
+    if (!os.flush())
+      return false;
+  }
+
+#if defined(_WIN32)
+  std::remove(path.c_str());    // Windows 的 rename 不會覆蓋已經存在的檔案
+#endif
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+bool MazeCheckpoint::load(const std::string &path, MazeGeneratorState &state, MazeGrid &maze,
+                          int32_t &begin_y, int32_t &begin_x, int32_t &end_y, int32_t &end_x)
+{
+  MAZE_TRACE_SCOPE("MazeCheckpoint::load");
+  std::ifstream is(path, std::ios::binary);
+  if (!is)
+    return false;
+
+  // 長度都是從檔案讀的，配置之前先確定檔案裡真的有這麼多 byte，壞掉的檔案不會變成 bad_alloc
+  is.seekg(0, std::ios::end);
+  const std::streamoff end_offset = is.tellg();
+  is.seekg(0, std::ios::beg);
+  if (end_offset < 0)
+    return false;
+  const uint64_t file_size = static_cast<uint64_t>(end_offset);
+
+  char magic[4];
+  uint32_t version;
+  int32_t algorithm, height, width;
+  MazeGeneratorState loaded;
+  if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 || !get(is, version) || version != VERSION)
+    return false;
+  if (!get(is, algorithm) || !get(is, loaded.seed) || !get(is, height) || !get(is, width) || height <= 0 || width <= 0)
+    return false;
+  if (algorithm != static_cast<int32_t>(MazeAction::G_PRIMS) && algorithm != static_cast<int32_t>(MazeAction::G_RECURSION_BACKTRACKER))
+    return false;
+  loaded.algorithm = static_cast<MazeAction>(algorithm);
+
+  int32_t by, bx, ey, ex;
+  MazeStats &stats = loaded.stats;
+  if (!get(is, by) || !get(is, bx) || !get(is, ey) || !get(is, ex))
+    return false;
+  if (by < 0 || by >= height || bx < 0 || bx >= width || ey < 0 || ey >= height || ex < 0 || ex >= width)
+    return false;
+  if (!get(is, stats.nodes_expanded) || !get(is, stats.pushes) || !get(is, stats.pops) || !get(is, stats.peak_open)
+      || !get(is, stats.peak_memory) || !get(is, stats.path_length) || !get(is, stats.elapsed_ms))
+    return false;
+  for (int32_t &dir : loaded.direction_order)
+    if (!get(is, dir) || dir < 0 || dir > 3)
+      return false;
+
+  uint64_t rng_length;
+  if (!get(is, rng_length) || rng_length > MAX_RNG_TEXT)
+    return false;
+  std::string rng_text(rng_length, '\0');
+  if (!is.read(rng_text.data(), static_cast<std::streamsize>(rng_length)))
+    return false;
+  std::istringstream rng(rng_text);
+  if (!(rng >> loaded.gen))
+    return false;
+
+  const uint64_t cells = static_cast<uint64_t>(height) * width;
+  if (cells + sizeof(CHECKPOINT_END) > remaining(is, file_size))    // grid 和 footer 在最後面
+    return false;
+  if (!getNodes(is, cells, file_size, loaded.explored_cache) || !getNodes(is, cells, file_size, loaded.frontier))
+    return false;
+
+  uint64_t frame_count;
+  if (!get(is, frame_count) || frame_count > cells || frame_count > remaining(is, file_size) / FRAME_BYTES)
+    return false;
+  std::vector<uint8_t> frames(frame_count * FRAME_BYTES);
+  if (!is.read(reinterpret_cast<char *>(frames.data()), static_cast<std::streamsize>(frames.size())))
+    return false;
+  loaded.stack.resize(frame_count);
+  const uint8_t *in = frames.data();
+  for (MazeTraceFrame &frame : loaded.stack) {
+    in = getNode(in, frame.node);
+    frame.index = static_cast<int8_t>(*in++);
+    std::copy(in, in + 4, frame.direction_order.begin());
+    in += 4;
+  }
+
+  // 之後的演算法會直接拿這些座標去讀 grid，先確定都在範圍裡
+  const auto inGrid = [&](const MazeNode &node) { return node.y >= 0 && node.y < height && node.x >= 0 && node.x < width; };
+  if (!std::all_of(loaded.explored_cache.begin(), loaded.explored_cache.end(), inGrid) || !std::all_of(loaded.frontier.begin(), loaded.frontier.end(), inGrid))
+    return false;
+  for (const MazeTraceFrame &frame : loaded.stack)
+    if (!inGrid(frame.node) || frame.index < 0 || frame.index > 4 || std::any_of(frame.direction_order.begin(), frame.direction_order.end(), [](const uint8_t dir) { return dir > 3; }))
+      return false;
+
+  MazeGrid grid(height, width);
+  char end[4];
+  if (!is.read(reinterpret_cast<char *>(grid.data()), static_cast<std::streamsize>(grid.size())) || !is.read(end, sizeof(end)) || std::memcmp(end, CHECKPOINT_END, sizeof(end)) != 0)
+    return false;
+
+  state = std::move(loaded);
+  maze = std::move(grid);
+  begin_y = by, begin_x = bx, end_y = ey, end_x = ex;
+  return true;
+}
@@ -1,6 +1,7 @@
 #include "MazeController.h"
 #include "MazeModel.h"
 #include "MazeView.h"
+#include "MazeTrace.h"
 
 #include <iostream>
 #include <thread>
@@ -14,64 +15,275 @@ void MazeController::setModelView(MazeModel *model_ptr, MazeView *view_ptr)
   this->view_ptr->setController(this);
 }
 
-void MazeController::handleInput(const MazeAction actions)
+MazeController::MazeController(const size_t worker_count, const bool pin_workers)
+    : pool{ worker_count, pin_workers },
+      scheduler{ std::make_unique<MazeJobScheduler>(pool, [this](MazeJob &job) { runJob(job); }) } {}
+
+/**
+ * @brief submit the action as a background job, the UI thread never touches the model so it stays responsive however large the maze is
+ *
+ * Jobs run one at a time on a worker of the shared thread pool, what happens to the previous jobs depends on the job policy.
+ */
+MazeJobHandle MazeController::handleInput(const MazeAction actions)
+{
+  return scheduler->submit(actions, job_policy.load());
+}
+
+/**
+ * @brief body of every job, runs on a pool worker
+ */
+void MazeController::runJob(MazeJob &job)
 {
-  std::thread t1;
+  const MazeAction actions = job.action();
+  cancel_token = job.cancelToken();
+  model_ptr->setCancelToken(cancel_token);
   model_complete_flag.store(false);
 
-  switch (actions) {
-  case MazeAction::G_RESET:
-    model_ptr->resetMaze();
-    break;
-  case MazeAction::G_PRIMS:
-    t1 = std::thread(&MazeModel::generateMazePrim, model_ptr);
-    t1.detach();
-    break;
-  case MazeAction::G_RECURSION_BACKTRACKER:
-    t1 = std::thread(&MazeModel::generateMazeRecursionBacktracker, model_ptr);
-    t1.detach();
-    break;
-  case MazeAction::G_RECURSION_DIVISION:
-    model_ptr->generateMazeRecursionDivision(1, 1, MAZE_HEIGHT - 2, MAZE_WIDTH - 2);
-    break;
-  case MazeAction::S_DFS:
-    model_ptr->solveMazeDFS(1, 0);
-    break;
-  case MazeAction::S_BFS:
-    model_ptr->solveMazeBFS();
-    break;
-  case MazeAction::S_UCS_MANHATTAN:
-    model_ptr->solveMazeUCS(actions);
-    break;
-  case MazeAction::S_UCS_TWO_NORM:
-    model_ptr->solveMazeUCS(actions);
-    break;
-  case MazeAction::S_UCS_INTERVAL:
-    model_ptr->solveMazeUCS(actions);
-    break;
-  case MazeAction::S_GREEDY:
-    model_ptr->solveMazeGreedy();
-    break;
-  case MazeAction::S_ASTAR:
-    model_ptr->solveMazeAStar(actions);
-    break;
-  case MazeAction::S_ASTAR_INTERVAL:
-    model_ptr->solveMazeAStar(actions);
-    break;
-  default:
-    std::clog << "invalid action" << std::endl;
-    break;
+  if (resync_needed)    // 被取消的工作可能丟掉了一些 diff，先把整張圖重送一次
+    model_ptr->resyncView();
+
+  if (job.hasTask()) {    // 存檔、讀檔這類不是演算法的工作，不錄也不算統計
+    job.runTask();
+    publishHeatmap(false);
+    shared_publisher.flush();
+    resync_needed = job.isCancelled();
+    model_ptr->setCancelToken(nullptr);
+    cancel_token = nullptr;
+    return;
   }
+
+  if (record_flag.load() && !replay_writer.open(REPLAY_PATH, model_ptr->height, model_ptr->width, actions, model_ptr->maze))
+    std::clog << "failed to write " << REPLAY_PATH << std::endl;
+
+  if (actions != MazeAction::G_RESET && actions != MazeAction::G_RECURSION_DIVISION && actions < MazeAction::S_DFS)
+    model_ptr->resetMaze();    // 除了 Division 都是在重設過的格子上挖路
+  model_ptr->setExpansionTracking(heatmap_flag.load());
+  const MazeStats stats = model_ptr->runAction(actions);
+  publishHeatmap(actions >= MazeAction::S_DFS);    // 取消的搜尋也留著，看得出它停在哪裡
+
+  if (replay_writer.isOpen() && !replay_writer.close(model_ptr->lastSeed()))
+    std::clog << "failed to write " << REPLAY_PATH << std::endl;
+
+  shared_publisher.flush();
+  resync_needed = job.isCancelled();
+  if (!job.isCancelled())
+    recordStats(actions, stats);    // 跑到一半的統計沒有意義
+
+  model_ptr->setCancelToken(nullptr);
+  cancel_token = nullptr;
+}
+
+void MazeController::setJobPolicy(const JobPolicy policy)
+{
+  job_policy.store(policy);
+}
+
+JobPolicy MazeController::getJobPolicy() const
+{
+  return job_policy.load();
+}
+
+void MazeController::cancelJobs()
+{
+  scheduler->cancelAll();
+}
+
+MazeJobHandle MazeController::currentJob() const
+{
+  return scheduler->current();
+}
+
+size_t MazeController::pendingJobs() const
+{
+  return scheduler->pendingCount();
 }
 
-void MazeController::setFrameMaze(const std::vector<std::vector<MazeElement>> &maze)
+bool MazeController::isJobRunning() const
 {
-  view_ptr->setFrameMaze(maze);
+  return scheduler->isBusy();
 }
 
-void MazeController::enFramequeue(const MazeNode &node)
+ThreadPool &MazeController::threadPool()
 {
-  view_ptr->enFramequeue(node);
+  return pool;
+}
+
+MazeJobHandle MazeController::saveMaze(const std::string &path, const MazeEncoding encoding)
+{
+  return scheduler->submit("Save", [this, path, encoding] {
+    if (!model_ptr->saveMaze(path, encoding))
+      std::clog << "failed to write " << path << std::endl;
+  }, job_policy.load());
+}
+
+/**
+ * @brief replace the maze with a saved one, the grid is mapped from the file instead of read into memory
+ *
+ * @param verify_checksum false skips reading the whole file once to check it, for huge files that are trusted
+ */
+MazeJobHandle MazeController::loadMaze(const std::string &path, const bool verify_checksum)
+{
+  return scheduler->submit("Load", [this, path, verify_checksum] {
+    if (!model_ptr->loadMaze(path, verify_checksum))
+      std::clog << "failed to read " << path << std::endl;
+  }, job_policy.load());
+}
+
+/**
+ * @brief write the maze as an image, with the last solution painted over it if asked, rows are encoded on the pool
+ */
+MazeJobHandle MazeController::exportImage(const std::string &path, const MazeExportOptions &options, const bool with_solution)
+{
+  return scheduler->submit("Export", [this, path, options, with_solution] {
+    const MazeOverlay overlay = with_solution ? model_ptr->solutionOverlay() : MazeOverlay{};
+    if (!MazeImage::exportGrid(path, model_ptr->maze, options, pool, with_solution ? &overlay : nullptr))
+      std::clog << "failed to write " << path << std::endl;
+  }, job_policy.load());
+}
+
+/**
+ * @brief replace the maze with one read from an image, begin / end fall back to the default corners if their colours are not found
+ */
+MazeJobHandle MazeController::importImage(const std::string &path, const MazeImportOptions &options)
+{
+  return scheduler->submit("Import", [this, path, options] {
+    MazeImportResult result;
+    if (!MazeImage::importGrid(path, options, pool, result)) {
+      std::clog << "failed to read " << path << std::endl;
+      return;
+    }
+    if (!model_ptr->setMaze(std::move(result.grid), result.begin_y, result.begin_x, result.end_y, result.end_x))
+      std::clog << "failed to use " << path << std::endl;
+  }, job_policy.load());
+}
+
+/**
+ * @brief checkpoint Prim and the backtracker to path every interval_seconds, call it before any job is submitted
+ */
+void MazeController::setCheckpoint(const std::string &path, const double interval_seconds)
+{
+  model_ptr->setCheckpoint(path, interval_seconds);
+}
+
+/**
+ * @brief publish the maze on screen in the shared-memory segment name, changes at most every interval_ms and at the
+ * end of every job, call it before any job is submitted
+ */
+bool MazeController::publishGrid(const std::string &name, const double interval_ms)
+{
+  return shared_publisher.open(name, model_ptr->maze, interval_ms);
+}
+
+/**
+ * @brief continue the generation checkpointed to path, a run cut short by a cancel or a crash ends with the maze it would have made
+ */
+MazeJobHandle MazeController::resumeGeneration(const std::string &path)
+{
+  return scheduler->submit("Resume", [this, path] {
+    const std::optional<MazeStats> stats = model_ptr->resumeGeneration(path);
+    if (!stats) {
+      std::clog << "failed to read " << path << std::endl;
+      return;
+    }
+    if (!cancel_token || !cancel_token->load())
+      recordStats(model_ptr->lastGenerator(), *stats);
+  }, job_policy.load());
+}
+
+void MazeController::setRecording(const bool enable)
+{
+  record_flag.store(enable);
+}
+
+bool MazeController::isRecording() const
+{
+  return record_flag.load();
+}
+
+/**
+ * @brief record the expansion order of every search and show it over the maze, one uint32_t per cell while enabled
+ */
+void MazeController::setHeatmap(const bool enable)
+{
+  heatmap_flag.store(enable);
+  if (!enable) {    // 關掉的時候迷宮可能還會變，留著的 layer 之後會對不上
+    std::lock_guard<std::mutex> lock(heatmap_mutex);
+    heatmap.reset();
+    ++heatmap_version;
+  }
+}
+
+bool MazeController::isHeatmapEnabled() const
+{
+  return heatmap_flag.load();
+}
+
+/**
+ * @brief the expansion order of the last search, version changes whenever a new one (or nullptr) is published
+ */
+std::shared_ptr<const MazeExpansionLayer> MazeController::getHeatmap(uint64_t &version)
+{
+  std::lock_guard<std::mutex> lock(heatmap_mutex);
+  version = heatmap_version;
+  return heatmap;
+}
+
+/**
+ * @brief write the expansion order of the last search as a false-colour image and as a raw uint32_t array
+ */
+MazeJobHandle MazeController::exportHeatmap(const std::string &path, const MazeExportOptions &options)
+{
+  return scheduler->submit("Heatmap", [this, path, options] {
+    const MazeExpansionLayer layer = model_ptr->expansionLayer();
+    if (layer.empty()) {
+      std::clog << "no expansion order to export, enable the heatmap and run a solver first" << std::endl;
+      return;
+    }
+    const std::string image_path = path + MazeImage::extension(options.format);
+    const std::string raw_path = path + "_" + std::to_string(layer.height) + "x" + std::to_string(layer.width) + ".u32";
+    if (!MazeImage::exportHeatmap(image_path, layer, model_ptr->maze, options, pool))
+      std::clog << "failed to write " << image_path << std::endl;
+    if (!MazeImage::exportRaw(raw_path, layer))
+      std::clog << "failed to write " << raw_path << std::endl;
+  }, job_policy.load());
+}
+
+/**
+ * @brief hand the view the layer of the search that just ran, or drop the old one once the maze has changed
+ */
+void MazeController::publishHeatmap(const bool searched)
+{
+  if (!heatmap_flag.load() || (!searched && model_ptr->hasExpansionLayer()))
+    return;
+
+  std::shared_ptr<const MazeExpansionLayer> layer;
+  if (searched) {
+    MazeExpansionLayer current = model_ptr->expansionLayer();
+    if (!current.empty())
+      layer = std::make_shared<const MazeExpansionLayer>(std::move(current));
+  }
+
+  std::lock_guard<std::mutex> lock(heatmap_mutex);
+  if (!layer && !heatmap)
+    return;
+  heatmap = std::move(layer);
+  ++heatmap_version;
+}
+
+void MazeController::setFrameMaze(const MazeGrid &maze)
+{
+  if (replay_writer.isOpen())
+    replay_writer.recordFrame(maze);
+  shared_publisher.recordFrame(maze);
+  view_ptr->setFrameMaze(maze, cancel_token);
+}
+
+void MazeController::enFramequeue(const MazeDiffBatch &batch)
+{
+  if (replay_writer.isOpen())
+    replay_writer.recordBatch(batch);
+  shared_publisher.recordBatch(batch);
+  view_ptr->enFramequeue(batch, cancel_token);
 }
 
 void MazeController::setModelComplete()
@@ -83,6 +295,18 @@ bool MazeController::isModelComplete() const
   return model_complete_flag.load();
 }
 
+void MazeController::recordStats(const MazeAction action, const MazeStats &stats)
+{
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  last_stats[static_cast<int32_t>(action)] = stats;
+}
+
+MazeStats MazeController::getStats(const MazeAction action)
+{
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  return last_stats[static_cast<int32_t>(action)];
+}
+
 void MazeController::InitMaze()
 {
   model_ptr->resetMaze();
@@ -0,0 +1,469 @@
+#include "MazeFile.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  constexpr char FILE_MAGIC[4]{ 'M', 'Z', 'B', 'F' };
+  constexpr uint8_t FLAG_ENDPOINTS = 1 << 0;
+  constexpr uint8_t FLAG_COSTS = 1 << 1;
+  constexpr size_t WRITE_CHUNK = size_t{ 1 } << 16;
+  constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+  constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+  struct MazeFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t payload_offset;
+    uint64_t cost_offset;    // 0 代表沒有 cost layer
+    uint64_t checksum;
+    int32_t height, width;
+    uint8_t encoding;
+    uint8_t flags;
+    uint16_t reserved0;
+    uint32_t seed;
+    int32_t algorithm;
+    int32_t begin_y, begin_x, end_y, end_x;
+    int32_t block_rows;    // 只有 RLE 用到
+    uint32_t reserved1;
+    uint64_t index_offset;    // RLE block 索引的位置
+    uint8_t reserved[40];    // 之後的版本加欄位用，payload 的位置不用動
+  };
+  static_assert(sizeof(MazeFileHeader) == 128, "the header is part of the file format");
+
+  uint64_t fnv1a(uint64_t hash, const uint8_t *data, const size_t count)
+  {
+    for (size_t i = 0; i < count; ++i)
+      hash = (hash ^ data[i]) * FNV_PRIME;
+    return hash;
+  }
+
+  constexpr uint8_t BLOCK_RUNS = 0;
+  constexpr uint8_t BLOCK_BITS = 1;
+
+  uint64_t payloadBytes(const MazeEncoding encoding, const uint64_t cells)
+  {
+    return encoding == MazeEncoding::BIT ? (cells + 7) / 8 : cells;
+  }
+
+  void writeVarint(std::vector<uint8_t> &out, uint64_t value)
+  {
+    for (; value >= 0x80; value >>= 7)
+      out.push_back(static_cast<uint8_t>(value | 0x80));
+    out.push_back(static_cast<uint8_t>(value));
+  }
+
+  bool readVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+  {
+    value = 0;
+    for (uint32_t shift = 0; p < end && shift < 64; shift += 7) {
+      const uint8_t byte = *p++;
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief lengths of the alternating wall / ground runs of one row, the first run is a wall run and may be empty
+   */
+  void encodeRunRow(const MazeElement *row, const int32_t width, std::vector<uint8_t> &out)
+  {
+    bool wall = true;
+    for (int32_t x = 0; x < width; wall = !wall) {
+      const int32_t begin = x;
+      while (x < width && (row[x] == MazeElement::WALL) == wall)
+        ++x;
+      writeVarint(out, static_cast<uint64_t>(x - begin));
+    }
+  }
+
+  bool decodeRunRow(const uint8_t *&p, const uint8_t *end, MazeElement *row, const int32_t width)
+  {
+    bool wall = true;
+    for (int32_t x = 0; x < width; wall = !wall) {
+      uint64_t length;
+      if (!readVarint(p, end, length) || length > static_cast<uint64_t>(width - x))
+        return false;
+      std::fill_n(row + x, length, wall ? MazeElement::WALL : MazeElement::GROUND);
+      x += static_cast<int32_t>(length);
+    }
+    return true;
+  }
+
+  void packBits(const MazeElement *cells, const uint64_t count, uint8_t *out)
+  {
+    std::fill_n(out, (count + 7) / 8, 0);
+    for (uint64_t i = 0; i < count; ++i)
+      if (cells[i] != MazeElement::WALL)
+        out[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+  }
+
+  void unpackBits(const uint8_t *bits, const uint64_t first, const int32_t count, MazeElement *out)
+  {
+    for (int32_t i = 0; i < count; ++i) {
+      const uint64_t bit = first + i;
+      out[i] = bits[bit >> 3] >> (bit & 7) & 1 ? MazeElement::GROUND : MazeElement::WALL;
+    }
+  }
+
+  bool inGrid(const int32_t y, const int32_t x, const int32_t height, const int32_t width)
+  {
+    return y >= 0 && y < height && x >= 0 && x < width;
+  }
+}    // namespace
+
+// 整個檔案映射到記憶體裡，MAP_PRIVATE 所以寫入只會改到自己的 page
+struct MazeFile::Mapping {
+  uint8_t *base = nullptr;
+  size_t length = 0;
+#if defined(_WIN32)
+  std::vector<uint8_t> buffer;    // 沒有 mmap 的平台整個讀進來
+#else
+  ~Mapping()
+  {
+    if (base)
+      munmap(base, length);
+  }
+#endif
+};
+
+/**
+ * @brief write grid to path, the dimensions come from grid and the checksum is computed while writing
+ *
+ * @param costs height * width step costs, written as the cost layer when info.has_costs is set
+ */
+bool MazeFile::save(const std::string &path, const MazeGrid &grid, MazeFileInfo info, const uint8_t *costs)
+{
+  MAZE_TRACE_SCOPE("MazeFile::save");
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (!os)
+    return false;
+
+  info.height = grid.height();
+  info.width = grid.width();
+  info.has_costs = info.has_costs && costs;
+  info.block_rows = std::max(info.block_rows, 1);
+  const uint64_t cells = grid.size();
+
+  MazeFileHeader header{};
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = VERSION;
+  header.payload_offset = sizeof(MazeFileHeader);
+  header.height = info.height;
+  header.width = info.width;
+  header.encoding = static_cast<uint8_t>(info.encoding);
+  header.flags = (info.has_endpoints ? FLAG_ENDPOINTS : 0) | (info.has_costs ? FLAG_COSTS : 0);
+  header.seed = info.seed;
+  header.algorithm = static_cast<int32_t>(info.algorithm);
+  header.begin_y = info.begin_y, header.begin_x = info.begin_x;
+  header.end_y = info.end_y, header.end_x = info.end_x;
+  header.block_rows = info.encoding == MazeEncoding::RLE ? info.block_rows : 0;
+  os.write(reinterpret_cast<const char *>(&header), sizeof(header));    // checksum 寫完 payload 再補
+
+  uint64_t checksum = FNV_OFFSET;
+  uint64_t offset = header.payload_offset;
+  const auto write = [&](const uint8_t *bytes, const size_t count) {
+    checksum = fnv1a(checksum, bytes, count);
+    os.write(reinterpret_cast<const char *>(bytes), static_cast<std::streamsize>(count));
+    offset += count;
+  };
+
+  const uint8_t *cell_bytes = reinterpret_cast<const uint8_t *>(grid.data());
+  if (info.encoding == MazeEncoding::BYTE) {
+    write(cell_bytes, cells);
+  }
+  else if (info.encoding == MazeEncoding::BIT) {
+    std::vector<uint8_t> packed(WRITE_CHUNK);
+    for (uint64_t begin = 0; begin < cells; begin += WRITE_CHUNK * 8) {
+      const uint64_t end = std::min<uint64_t>(begin + WRITE_CHUNK * 8, cells);
+      packBits(grid.data() + begin, end - begin, packed.data());
+      write(packed.data(), static_cast<size_t>((end - begin + 7) / 8));
+    }
+  }
+  else {
+    // 每個 block 各自選 runs 或 bits 比較小的那個，牆很碎的迷宮也不會比 BIT 大
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> block;
+    for (int32_t y0 = 0; y0 < info.height; y0 += info.block_rows) {
+      const int32_t y1 = std::min(y0 + info.block_rows, info.height);
+      const uint64_t block_cells = static_cast<uint64_t>(y1 - y0) * info.width;
+      index.push_back(offset);
+      block.assign(1, BLOCK_RUNS);
+      for (int32_t y = y0; y < y1; ++y)
+        encodeRunRow(grid[y], info.width, block);
+      if (block.size() - 1 > (block_cells + 7) / 8) {
+        block.assign(1 + (block_cells + 7) / 8, 0);
+        block[0] = BLOCK_BITS;
+        packBits(grid[y0], block_cells, block.data() + 1);
+      }
+      write(block.data(), block.size());
+    }
+    index.push_back(offset);
+    header.index_offset = offset;
+    write(reinterpret_cast<const uint8_t *>(index.data()), index.size() * sizeof(uint64_t));
+  }
+
+  if (info.has_costs) {
+    header.cost_offset = offset;
+    write(costs, cells);
+  }
+
+  header.checksum = checksum;
+  os.seekp(0);
+  os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  return static_cast<bool>(os);
+}
+
+/**
+ * @brief map the file and check that the header and every layer it describes fit in it, the checksum is not checked here
+ */
+bool MazeFile::open(const std::string &path)
+{
+  MAZE_TRACE_SCOPE("MazeFile::open");
+  close();
+  auto map = std::make_shared<Mapping>();
+
+#if defined(_WIN32)
+  std::ifstream is(path, std::ios::binary);
+  if (!is)
+    return false;
+  map->buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+  map->base = map->buffer.data();
+  map->length = map->buffer.size();
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MazeFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);    // mapping 會自己持有檔案
+  if (base == MAP_FAILED)
+    return false;
+  map->base = static_cast<uint8_t *>(base);
+  map->length = static_cast<size_t>(st.st_size);
+#endif
+
+  if (map->length < sizeof(MazeFileHeader))
+    return false;
+  MazeFileHeader header;
+  std::memcpy(&header, map->base, sizeof(header));
+  if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != VERSION || header.height <= 0 || header.width <= 0 || header.encoding > static_cast<uint8_t>(MazeEncoding::RLE))
+    return false;
+  if (header.algorithm < static_cast<int32_t>(MazeAction::G_RESET) || header.algorithm >= static_cast<int32_t>(MazeAction::S_DFS))
+    return false;    // 只會存生成演算法
+  if (!fitsCellIndex(header.height, header.width)) {
+    std::clog << path << ": " << header.height << 'x' << header.width << " has more cells than a 32-bit cell index can address" << std::endl;
+    return false;
+  }
+
+  MazeFileInfo info;
+  info.height = header.height;
+  info.width = header.width;
+  info.encoding = static_cast<MazeEncoding>(header.encoding);
+  info.block_rows = header.block_rows;
+  info.seed = header.seed;
+  info.algorithm = static_cast<MazeAction>(header.algorithm);
+  info.has_endpoints = header.flags & FLAG_ENDPOINTS;
+  info.begin_y = header.begin_y, info.begin_x = header.begin_x;
+  info.end_y = header.end_y, info.end_x = header.end_x;
+  info.has_costs = header.flags & FLAG_COSTS;
+  info.checksum = header.checksum;
+
+  const uint64_t cells = static_cast<uint64_t>(info.height) * info.width;
+  uint64_t bytes = payloadBytes(info.encoding, cells);
+  if (info.encoding == MazeEncoding::RLE) {
+    // 索引要剛好接在 block 後面，每個 block 至少有 tag，這樣之後解碼只需要檢查 block 內部
+    if (info.block_rows <= 0 || header.index_offset < header.payload_offset)
+      return false;
+    const uint64_t block_count = (static_cast<uint64_t>(info.height) + info.block_rows - 1) / info.block_rows;
+    const uint64_t index_bytes = (block_count + 1) * sizeof(uint64_t);
+    if (header.index_offset > map->length || index_bytes > map->length - header.index_offset)
+      return false;
+    uint64_t previous = header.payload_offset;
+    for (uint64_t block = 0; block <= block_count; ++block) {
+      uint64_t block_offset;
+      std::memcpy(&block_offset, map->base + header.index_offset + block * sizeof(uint64_t), sizeof(block_offset));
+      if (block == 0 ? block_offset != header.payload_offset : block_offset <= previous)
+        return false;
+      previous = block_offset;
+    }
+    if (previous != header.index_offset)
+      return false;
+    bytes = header.index_offset + index_bytes - header.payload_offset;
+  }
+  // offset 是從檔案讀的，先比 offset 再比剩下的長度，相加可能會溢位
+  if (header.payload_offset < sizeof(MazeFileHeader) || header.payload_offset > map->length || bytes > map->length - header.payload_offset)
+    return false;
+  if (info.has_costs && (header.cost_offset < sizeof(MazeFileHeader) || header.cost_offset > map->length || cells > map->length - header.cost_offset))
+    return false;
+  if (info.has_endpoints && (!inGrid(info.begin_y, info.begin_x, info.height, info.width) || !inGrid(info.end_y, info.end_x, info.height, info.width)))
+    return false;
+
+  mapping = std::move(map);
+  file_info = info;
+  payload_offset = header.payload_offset;
+  payload_bytes = bytes;
+  index_offset = info.encoding == MazeEncoding::RLE ? header.index_offset : 0;
+  cost_offset = info.has_costs ? header.cost_offset : 0;
+  return true;
+}
+
+void MazeFile::close()
+{
+  mapping.reset();
+  file_info = MazeFileInfo{};
+  payload_offset = payload_bytes = cost_offset = index_offset = 0;
+}
+
+/**
+ * @brief the maze of the file, grids of a BYTE file are views of the same copy-on-write mapped cells
+ *
+ * BIT / RLE files are decoded into a new grid, in parallel on pool when there is one. Returns an empty grid when a
+ * block of an RLE file is corrupt.
+ */
+MazeGrid MazeFile::grid(ThreadPool *pool) const
+{
+  if (!isOpen())
+    return MazeGrid{};
+
+  uint8_t *payload = mapping->base + payload_offset;
+  if (file_info.encoding == MazeEncoding::BYTE)
+    return MazeGrid::wrap(reinterpret_cast<MazeElement *>(payload), file_info.height, file_info.width, mapping);
+
+  MAZE_TRACE_SCOPE("MazeFile::unpack");
+  MazeGrid grid(file_info.height, file_info.width, MazeElement::WALL);
+  std::atomic<bool> ok{ true };
+  const auto decode = [&](const size_t y0, const size_t y1) {
+    const bool decoded = streamRows(static_cast<int32_t>(y0), static_cast<int32_t>(y1), [&](const int32_t y, const MazeElement *row) {
+      std::copy_n(row, file_info.width, grid[y]);
+    });
+    if (!decoded)
+      ok.store(false, std::memory_order_relaxed);
+  };
+
+  // chunk 對齊 block，每個 block 只會被解一次
+  const size_t grain = file_info.encoding == MazeEncoding::RLE ? static_cast<size_t>(file_info.block_rows) : 256;
+  if (pool)
+    pool->parallelFor(0, static_cast<size_t>(file_info.height), grain, decode);
+  else
+    decode(0, static_cast<size_t>(file_info.height));
+  return ok.load() ? std::move(grid) : MazeGrid{};
+}
+
+/**
+ * @brief decode rows [y0, y1) one at a time into sink, without building the grid
+ *
+ * An RLE file only touches the blocks that hold the range. Returns false when the file is not open, the range is out
+ * of the maze or a block is corrupt; the rows before the corrupt one have already been delivered.
+ */
+bool MazeFile::streamRows(const int32_t y0, const int32_t y1, const MazeRowSink &sink) const
+{
+  if (!isOpen() || y0 < 0 || y1 > file_info.height || y0 > y1)
+    return false;
+
+  const int32_t width = file_info.width;
+  const uint8_t *payload = mapping->base + payload_offset;
+  if (file_info.encoding == MazeEncoding::BYTE) {
+    for (int32_t y = y0; y < y1; ++y)
+      sink(y, reinterpret_cast<const MazeElement *>(payload) + static_cast<size_t>(y) * width);
+    return true;
+  }
+
+  std::vector<MazeElement> row(static_cast<size_t>(width));
+  if (file_info.encoding == MazeEncoding::BIT) {
+    for (int32_t y = y0; y < y1; ++y) {
+      unpackBits(payload, static_cast<uint64_t>(y) * width, width, row.data());
+      paintEndpoints(y, row.data());
+      sink(y, row.data());
+    }
+    return true;
+  }
+
+  const int32_t block_rows = file_info.block_rows;
+  for (int32_t block_y = y0 - y0 % block_rows; block_y < y1; block_y += block_rows) {
+    const size_t block = static_cast<size_t>(block_y / block_rows);
+    const uint8_t *p = mapping->base + blockOffset(block);
+    const uint8_t *end = mapping->base + blockOffset(block + 1);
+    const uint8_t tag = *p++;
+    const int32_t last = std::min(block_y + block_rows, y1);
+    for (int32_t y = block_y; y < last; ++y) {
+      if (tag == BLOCK_BITS) {
+        const uint64_t first = static_cast<uint64_t>(y - block_y) * width;
+        if (first + width > static_cast<uint64_t>(end - p) * 8)
+          return false;
+        if (y < y0)
+          continue;
+        unpackBits(p, first, width, row.data());
+      }
+      else if (tag != BLOCK_RUNS || !decodeRunRow(p, end, row.data(), width)) {
+        return false;
+      }
+      else if (y < y0) {
+        continue;    // runs 要從 block 開頭依序讀
+      }
+      paintEndpoints(y, row.data());
+      sink(y, row.data());
+    }
+  }
+  return true;
+}
+
+uint64_t MazeFile::blockOffset(const size_t block) const
+{
+  uint64_t offset;
+  std::memcpy(&offset, mapping->base + index_offset + block * sizeof(uint64_t), sizeof(offset));
+  return offset;
+}
+
+void MazeFile::paintEndpoints(const int32_t y, MazeElement *row) const
+{
+  if (!file_info.has_endpoints)
+    return;
+  if (y == file_info.begin_y)
+    row[file_info.begin_x] = MazeElement::BEGIN;
+  if (y == file_info.end_y)
+    row[file_info.end_x] = MazeElement::END;
+}
+
+const uint8_t *MazeFile::costs() const
+{
+  return isOpen() && file_info.has_costs ? mapping->base + cost_offset : nullptr;
+}
+
+/**
+ * @brief recompute the checksum, this reads the whole file
+ *
+ * Only meaningful before the cells of a grid() of a BYTE file are changed, they share the mapped pages.
+ */
+bool MazeFile::verify() const
+{
+  MAZE_TRACE_SCOPE("MazeFile::verify");
+  if (!isOpen())
+    return false;
+
+  const uint64_t cells = static_cast<uint64_t>(file_info.height) * file_info.width;
+  uint64_t checksum = fnv1a(FNV_OFFSET, mapping->base + payload_offset, payload_bytes);
+  if (file_info.has_costs)
+    checksum = fnv1a(checksum, mapping->base + cost_offset, cells);
+  return checksum == file_info.checksum;
+}
@@ -0,0 +1,353 @@
+#include "MazeImage.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"    // stb 自己的程式碼
+#endif
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+  int32_t channelCount(const ImageFormat format)
+  {
+    return format == ImageFormat::PGM ? 1 : 3;
+  }
+
+  // 每個 MazeElement (int8) 對應的像素，整列編碼的時候直接查表
+  std::array<std::array<uint8_t, 3>, 256> buildLookup(const MazePalette &palette, const bool gray)
+  {
+    std::array<std::array<uint8_t, 3>, 256> lookup{};
+    for (int32_t i = 0; i < 256; ++i) {
+      const uint32_t color = palette.color(static_cast<MazeElement>(static_cast<int8_t>(i)));
+      const uint8_t r = color >> 16 & 0xFF, g = color >> 8 & 0xFF, b = color & 0xFF;
+      if (gray)
+        lookup[i][0] = static_cast<uint8_t>((r * 299 + g * 587 + b * 114) / 1000);
+      else
+        lookup[i] = { r, g, b };
+    }
+    return lookup;
+  }
+
+  // viridis 的 256 階，展開順序從早到晚，灰階的時候由暗到亮
+  std::array<std::array<uint8_t, 3>, 256> buildRamp(const bool gray)
+  {
+    static constexpr uint32_t keys[]{ 0x440154, 0x3B528B, 0x21908C, 0x5DC963, 0xFDE725 };
+    constexpr int32_t segments = static_cast<int32_t>(std::size(keys)) - 1;
+    std::array<std::array<uint8_t, 3>, 256> ramp{};
+    for (int32_t i = 0; i < 256; ++i) {
+      const int32_t segment = std::min(i * segments / 255, segments - 1);
+      const int32_t t = i * segments - segment * 255;    // 在這一段裡的位置，0 ~ 255
+      uint8_t rgb[3];
+      for (int32_t c = 0; c < 3; ++c) {
+        const int32_t shift = 16 - 8 * c;
+        const int32_t from = keys[segment] >> shift & 0xFF, to = keys[segment + 1] >> shift & 0xFF;
+        rgb[c] = static_cast<uint8_t>(from + (to - from) * t / 255);
+      }
+      if (gray)
+        ramp[i][0] = static_cast<uint8_t>((rgb[0] * 299 + rgb[1] * 587 + rgb[2] * 114) / 1000);
+      else
+        ramp[i] = { rgb[0], rgb[1], rgb[2] };
+    }
+    return ramp;
+  }
+
+  // 整數版的 Rec. 601 亮度，(77 + 150 + 29) / 256 = 1
+  uint32_t luminance(const uint32_t r, const uint32_t g, const uint32_t b)
+  {
+    return (r * 77 + g * 150 + b * 29) >> 8;
+  }
+
+  bool matchColor(const uint32_t r, const uint32_t g, const uint32_t b, const uint32_t key, const int32_t tolerance)
+  {
+    return std::abs(static_cast<int32_t>(r) - static_cast<int32_t>(key >> 16 & 0xFF)) <= tolerance
+           && std::abs(static_cast<int32_t>(g) - static_cast<int32_t>(key >> 8 & 0xFF)) <= tolerance
+           && std::abs(static_cast<int32_t>(b) - static_cast<int32_t>(key & 0xFF)) <= tolerance;
+  }
+}    // namespace
+
+const char *MazeImage::extension(const ImageFormat format)
+{
+  switch (format) {
+  case ImageFormat::PGM: return ".pgm";
+  case ImageFormat::PPM: return ".ppm";
+  case ImageFormat::PNG: return ".png";
+  }
+  return "";
+}
+
+/**
+ * @brief encode the cell rows [y0, y1) into out, pixels_per_cell pixel rows per cell row
+ */
+void MazeImage::encodeRows(const MazeGrid &grid, const MazeExportOptions &options, const MazeOverlay *overlay, const int32_t y0, const int32_t y1, uint8_t *out)
+{
+  const int32_t channels = channelCount(options.format);
+  const int32_t scale = options.pixels_per_cell;
+  const size_t width = static_cast<size_t>(grid.width());
+  const size_t row_bytes = width * scale * channels;
+  const auto lookup = buildLookup(options.palette, channels == 1);
+
+  std::vector<MazeElement> cells(width);
+  auto paint = overlay ? std::lower_bound(overlay->begin(), overlay->end(), static_cast<uint32_t>(static_cast<size_t>(y0) * width), [](const std::pair<uint32_t, MazeElement> &cell, const uint32_t index) { return cell.first < index; }) : MazeOverlay::const_iterator{};
+
+  for (int32_t y = y0; y < y1; ++y) {
+    std::copy(grid[y], grid[y] + width, cells.begin());
+    if (overlay) {
+      const size_t row_end = static_cast<size_t>(y + 1) * width;
+      for (; paint != overlay->end() && paint->first < row_end; ++paint)
+        cells[paint->first - static_cast<size_t>(y) * width] = paint->second;
+    }
+
+    uint8_t *row = out + static_cast<size_t>(y - y0) * scale * row_bytes;
+    uint8_t *pixel = row;
+    for (size_t x = 0; x < width; ++x) {
+      const std::array<uint8_t, 3> &color = lookup[static_cast<uint8_t>(cells[x])];
+      for (int32_t s = 0; s < scale; ++s, pixel += channels)
+        std::memcpy(pixel, color.data(), channels);
+    }
+    for (int32_t s = 1; s < scale; ++s)
+      std::memcpy(row + s * row_bytes, row, row_bytes);
+  }
+}
+
+/**
+ * @brief encode the cell rows [y0, y1) of layer into out, like encodeRows
+ */
+void MazeImage::encodeHeatmapRows(const MazeExpansionLayer &layer, const MazeGrid &grid, const MazeExportOptions &options, const int32_t y0, const int32_t y1, uint8_t *out)
+{
+  const int32_t channels = channelCount(options.format);
+  const int32_t scale = options.pixels_per_cell;
+  const size_t width = static_cast<size_t>(grid.width());
+  const size_t row_bytes = width * scale * channels;
+  const auto lookup = buildLookup(options.palette, channels == 1);
+  const auto ramp = buildRamp(channels == 1);
+  const uint64_t span = std::max<uint64_t>(layer.expanded, 2) - 1;
+
+  for (int32_t y = y0; y < y1; ++y) {
+    const uint32_t *order = layer.order.data() + static_cast<size_t>(y) * width;
+    const MazeElement *cells = grid[y];
+    uint8_t *row = out + static_cast<size_t>(y - y0) * scale * row_bytes;
+    uint8_t *pixel = row;
+    for (size_t x = 0; x < width; ++x) {
+      const std::array<uint8_t, 3> &color = order[x] ? ramp[(order[x] - uint64_t{ 1 }) * 255 / span] : lookup[static_cast<uint8_t>(cells[x])];
+      for (int32_t s = 0; s < scale; ++s, pixel += channels)
+        std::memcpy(pixel, color.data(), channels);
+    }
+    for (int32_t s = 1; s < scale; ++s)
+      std::memcpy(row + s * row_bytes, row, row_bytes);
+  }
+}
+
+/**
+ * @brief write grid as an image, chunks of rows_per_chunk rows are encoded in parallel on the pool
+ *
+ * @param overlay cells painted over the grid (the last solution), sorted by index, a stable sort keeps the order
+ *                of repeated cells
+ */
+bool MazeImage::exportGrid(const std::string &path, const MazeGrid &grid, const MazeExportOptions &options, ThreadPool &pool, const MazeOverlay *overlay)
+{
+  MAZE_TRACE_SCOPE("MazeImage::exportGrid");
+  return writeImage(path, grid.height(), grid.width(), options, pool, [&](const int32_t y0, const int32_t y1, uint8_t *out) {
+    encodeRows(grid, options, overlay, y0, y1, out);
+  });
+}
+
+/**
+ * @brief write the expansion order of layer as a false-colour image, the cells it did not expand show grid
+ */
+bool MazeImage::exportHeatmap(const std::string &path, const MazeExpansionLayer &layer, const MazeGrid &grid, const MazeExportOptions &options, ThreadPool &pool)
+{
+  MAZE_TRACE_SCOPE("MazeImage::exportHeatmap");
+  if (layer.empty() || layer.height != grid.height() || layer.width != grid.width())
+    return false;
+  return writeImage(path, grid.height(), grid.width(), options, pool, [&](const int32_t y0, const int32_t y1, uint8_t *out) {
+    encodeHeatmapRows(layer, grid, options, y0, y1, out);
+  });
+}
+
+/**
+ * @brief write layer.order as height * width little-endian uint32_t, row-major, with no header
+ */
+bool MazeImage::exportRaw(const std::string &path, const MazeExpansionLayer &layer)
+{
+  MAZE_TRACE_SCOPE("MazeImage::exportRaw");
+  if (layer.empty())
+    return false;
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(reinterpret_cast<const char *>(layer.order.data()), static_cast<std::streamsize>(layer.order.size() * sizeof(uint32_t)));
+  return static_cast<bool>(os);
+}
+
+/**
+ * @brief the image of height x width cells, chunks of rows_per_chunk rows are encoded in parallel on the pool
+ *
+ * PGM / PPM keep only a window of chunks in memory, PNG needs the whole image.
+ */
+bool MazeImage::writeImage(const std::string &path, const int32_t height, const int32_t width, const MazeExportOptions &options, ThreadPool &pool, const RowEncoder &encode)
+{
+  if (height <= 0 || width <= 0 || options.pixels_per_cell < 1 || options.rows_per_chunk < 1)
+    return false;
+
+  const int32_t channels = channelCount(options.format);
+  const uint64_t image_w = static_cast<uint64_t>(width) * options.pixels_per_cell;
+  const uint64_t image_h = static_cast<uint64_t>(height) * options.pixels_per_cell;
+  const size_t row_bytes = static_cast<size_t>(image_w) * channels;
+  const size_t chunk_count = (static_cast<size_t>(height) + options.rows_per_chunk - 1) / options.rows_per_chunk;
+  const auto chunk_rows = [&](const size_t chunk) {
+    const int32_t y0 = static_cast<int32_t>(chunk * options.rows_per_chunk);
+    return std::make_pair(y0, std::min(y0 + options.rows_per_chunk, height));
+  };
+
+  if (options.format == ImageFormat::PNG) {
+    if (image_h * row_bytes > MAX_PNG_BYTES || image_w > INT_MAX || image_h > INT_MAX)
+      return false;    // stb 要整張圖在記憶體裡，太大的請用 PGM / PPM
+
+    std::vector<uint8_t> image(static_cast<size_t>(image_h) * row_bytes);
+    pool.parallelFor(0, chunk_count, 1, [&](const size_t begin, const size_t end) {
+      for (size_t chunk = begin; chunk < end; ++chunk) {
+        const auto [y0, y1] = chunk_rows(chunk);
+        encode(y0, y1, image.data() + static_cast<size_t>(y0) * options.pixels_per_cell * row_bytes);
+      }
+    });
+    return stbi_write_png(path.c_str(), static_cast<int>(image_w), static_cast<int>(image_h), channels, image.data(), static_cast<int>(row_bytes)) != 0;
+  }
+
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  if (!os)
+    return false;
+  os << (options.format == ImageFormat::PGM ? "P5" : "P6") << '\n' << image_w << ' ' << image_h << "\n255\n";
+
+  // 一次只編碼一個視窗的 chunk，編好之後照順序寫出去，記憶體用量和迷宮大小無關
+  const size_t window = std::max<size_t>(pool.size(), 1) * 2;
+  std::vector<std::vector<uint8_t>> buffers(window);
+  for (size_t first = 0; first < chunk_count && os; first += window) {
+    const size_t count = std::min(window, chunk_count - first);
+    pool.parallelFor(0, count, 1, [&](const size_t begin, const size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const auto [y0, y1] = chunk_rows(first + i);
+        buffers[i].resize(static_cast<size_t>(y1 - y0) * options.pixels_per_cell * row_bytes);
+        encode(y0, y1, buffers[i].data());
+      }
+    });
+    for (size_t i = 0; i < count; ++i)
+      os.write(reinterpret_cast<const char *>(buffers[i].data()), static_cast<std::streamsize>(buffers[i].size()));
+  }
+  return static_cast<bool>(os);
+}
+
+/**
+ * @brief convert the cell rows [y0, y1) of the RGB image, and report the first begin / end block in them (-1 if none)
+ *
+ * The scale pixel rows of a cell row are first added into one row of interleaved channel sums, a contiguous
+ * uint8 -> uint32 add the compiler vectorises (check with -fopt-info-vec). Collapsing each cell's scale columns
+ * afterwards touches 1 / scale as many values, then every cell is classified from its mean colour.
+ */
+void MazeImage::decodeRows(const uint8_t *pixels, const int32_t image_w, const MazeImportOptions &options, const int32_t y0, const int32_t y1, MazeGrid &grid, int64_t &first_begin, int64_t &first_end)
+{
+  const int32_t scale = options.pixels_per_cell;
+  const size_t width = static_cast<size_t>(grid.width());
+  const size_t stride = static_cast<size_t>(image_w) * 3;
+  const size_t used_bytes = width * scale * 3;    // 圖寬不是 scale 的倍數的話，右邊多出來的像素不用
+  const uint32_t block = static_cast<uint32_t>(scale) * scale;
+  std::vector<uint32_t> row_sum(used_bytes);    // 這一列格子的每個像素、每個 channel 在 scale 行上的和
+  std::vector<uint32_t> sum_r(width), sum_g(width), sum_b(width);
+  first_begin = first_end = -1;
+
+  for (int32_t y = y0; y < y1; ++y) {
+    std::fill(row_sum.begin(), row_sum.end(), 0);
+    uint32_t *sum = row_sum.data();
+    for (int32_t py = 0; py < scale; ++py) {
+      const uint8_t *row = pixels + (static_cast<size_t>(y) * scale + py) * stride;
+      for (size_t i = 0; i < used_bytes; ++i)
+        sum[i] += row[i];
+    }
+
+    const uint32_t *pixel = row_sum.data();
+    for (size_t x = 0; x < width; ++x) {
+      uint32_t r = 0, g = 0, b = 0;
+      for (int32_t px = 0; px < scale; ++px, pixel += 3)
+        r += pixel[0], g += pixel[1], b += pixel[2];
+      sum_r[x] = r, sum_g[x] = g, sum_b[x] = b;
+    }
+
+    MazeElement *cells = grid[y];
+    for (size_t x = 0; x < width; ++x) {
+      const uint32_t r = sum_r[x] / block, g = sum_g[x] / block, b = sum_b[x] / block;
+      cells[x] = luminance(r, g, b) < options.wall_threshold ? MazeElement::WALL : MazeElement::GROUND;
+    }
+
+    if (!options.detect_endpoints || (first_begin >= 0 && first_end >= 0))
+      continue;
+    for (size_t x = 0; x < width; ++x) {
+      const uint32_t r = sum_r[x] / block, g = sum_g[x] / block, b = sum_b[x] / block;
+      const int64_t index = static_cast<int64_t>(y) * width + x;
+      if (first_begin < 0 && matchColor(r, g, b, options.begin_color, options.color_tolerance))
+        first_begin = index;
+      else if (first_end < 0 && matchColor(r, g, b, options.end_color, options.color_tolerance))
+        first_end = index;
+    }
+  }
+}
+
+/**
+ * @brief load an image and turn it into a grid, the image size is cut down to a whole number of cells
+ */
+bool MazeImage::importGrid(const std::string &path, const MazeImportOptions &options, ThreadPool &pool, MazeImportResult &result)
+{
+  MAZE_TRACE_SCOPE("MazeImage::importGrid");
+  if (options.pixels_per_cell < 1 || options.rows_per_chunk < 1)
+    return false;
+
+  int32_t image_w = 0, image_h = 0, channels = 0;
+  const std::unique_ptr<uint8_t, void (*)(void *)> pixels(stbi_load(path.c_str(), &image_w, &image_h, &channels, 3), stbi_image_free);
+  if (!pixels)
+    return false;
+
+  const int32_t height = image_h / options.pixels_per_cell, width = image_w / options.pixels_per_cell;
+  if (height == 0 || width == 0)
+    return false;
+  if (!fitsCellIndex(height, width)) {
+    std::clog << path << ": " << height << 'x' << width << " has more cells than a 32-bit cell index can address" << std::endl;
+    return false;
+  }
+
+  MazeGrid grid(height, width, MazeElement::WALL);
+  const size_t chunk_count = (static_cast<size_t>(height) + options.rows_per_chunk - 1) / options.rows_per_chunk;
+  std::vector<int64_t> first_begin(chunk_count, -1), first_end(chunk_count, -1);
+  pool.parallelFor(0, chunk_count, 1, [&](const size_t begin, const size_t end) {
+    for (size_t chunk = begin; chunk < end; ++chunk) {
+      const int32_t y0 = static_cast<int32_t>(chunk * options.rows_per_chunk);
+      decodeRows(pixels.get(), image_w, options, y0, std::min(y0 + options.rows_per_chunk, height), grid, first_begin[chunk], first_end[chunk]);
+    }
+  });
+
+  // chunk 照列的順序排，第一個有找到的 chunk 就是 row-major 的第一個
+  result = MazeImportResult{};
+  for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+    if (result.begin_y < 0 && first_begin[chunk] >= 0) {
+      result.begin_y = static_cast<int32_t>(first_begin[chunk] / width), result.begin_x = static_cast<int32_t>(first_begin[chunk] % width);
+      grid[result.begin_y][result.begin_x] = MazeElement::BEGIN;
+    }
+    if (result.end_y < 0 && first_end[chunk] >= 0) {
+      result.end_y = static_cast<int32_t>(first_end[chunk] / width), result.end_x = static_cast<int32_t>(first_end[chunk] % width);
+      grid[result.end_y][result.end_x] = MazeElement::END;
+    }
+  }
+  result.grid = std::move(grid);
+  return true;
+}
@@ -0,0 +1,106 @@
+#include "MazeJob.h"
+#include "MazeTrace.h"
+
+MazeJobScheduler::MazeJobScheduler(ThreadPool &pool, JobFunction run_job)
+    : pool{ pool }, run_job{ std::move(run_job) }, next_id{ 1 }, draining{ false } {}
+
+// 取消所有工作，等 drain 跑完離開，之後 pool 裡不會再有碰到這個物件的工作
+MazeJobScheduler::~MazeJobScheduler()
+{
+  cancelAll();
+  std::unique_lock<std::mutex> lock(mtx);
+  idle_cv.wait(lock, [this] { return !draining; });
+}
+
+MazeJobHandle MazeJobScheduler::submit(const MazeAction action, const JobPolicy policy)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return enqueue(std::make_shared<MazeJob>(next_id++, action), policy);
+}
+
+MazeJobHandle MazeJobScheduler::submit(std::string name, MazeJob::Task task, const JobPolicy policy)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return enqueue(std::make_shared<MazeJob>(next_id++, std::move(name), std::move(task)), policy);
+}
+
+/**
+ * @brief queue a job, caller holds mtx
+ *
+ * With CANCEL_PREVIOUS the running job is told to stop and every pending job is dropped first.
+ */
+MazeJobHandle MazeJobScheduler::enqueue(MazeJobHandle job, const JobPolicy policy)
+{
+  if (policy == JobPolicy::CANCEL_PREVIOUS) {
+    if (running)
+      running->cancel();
+    for (const MazeJobHandle &old_job : pending) {
+      old_job->cancel();
+      old_job->setState(JobState::CANCELLED);
+    }
+    pending.clear();
+  }
+  pending.push_back(job);
+  if (draining)
+    return job;    // 正在跑的 drain 會接著跑它
+  draining = true;
+  pool.post([this] { drain(); });
+  return job;
+}
+
+void MazeJobScheduler::cancelAll()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  if (running)
+    running->cancel();
+  for (const MazeJobHandle &job : pending) {
+    job->cancel();
+    job->setState(JobState::CANCELLED);
+  }
+  pending.clear();
+}
+
+MazeJobHandle MazeJobScheduler::current() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return running;
+}
+
+size_t MazeJobScheduler::pendingCount() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return pending.size();
+}
+
+bool MazeJobScheduler::isBusy() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return running || !pending.empty();
+}
+
+/**
+ * @brief run pending jobs until the queue is empty, always on a single pool worker at a time
+ */
+void MazeJobScheduler::drain()
+{
+  while (true) {
+    MazeJobHandle job;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      running.reset();
+      if (pending.empty()) {
+        draining = false;
+        idle_cv.notify_all();
+        return;
+      }
+      job = pending.front();
+      pending.pop_front();
+      running = job;
+    }
+
+    MAZE_TRACE_SCOPE("MazeJob");
+    job->setState(JobState::RUNNING);
+    run_job(*job);
+    job->setState(job->isCancelled() ? JobState::CANCELLED : JobState::DONE);
+  }
+}
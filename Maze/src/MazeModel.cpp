@@ -1,37 +1,59 @@
-#include "MazeController.h"
 #include "MazeModel.h"
-#include "MazeView.h"
 #include "MazeNode.h"
+#include "MazeTrace.h"
 
 #include <chrono>
 #include <random>
 #include <algorithm>
 #include <stack>
 #include <queue>
+#include <cstdlib>
 #include <array>
 #include <utility>
 #include <memory>
 #include <iostream>
+#include <cstdio>
 
 MazeModel::MazeModel(uint32_t height, uint32_t width)
-    : maze{ height, std::vector<MazeElement>{ width, MazeElement::GROUND } } {}
+    : maze{ static_cast<int32_t>(height), static_cast<int32_t>(width), MazeElement::GROUND },
+      height{ static_cast<int32_t>(height) },
+      width{ static_cast<int32_t>(width) },
+      begin_y{ BEGIN_Y },
+      begin_x{ BEGIN_X },
+      end_y{ static_cast<int32_t>(height) - 2 },
+      end_x{ static_cast<int32_t>(width) - 1 },
+      controller_ptr{ nullptr },
+      visited(static_cast<size_t>(height) * width, 0),
+      parent(static_cast<size_t>(height) * width, 0),
+      visit_epoch{ 0 },
+      last_seed{ 0 },
+      last_generator{ MazeAction::G_RESET },
+      cancel_token{ nullptr },
+      checkpoint_seconds{ 0.0 },
+      checkpoint_tick{ 0 },
+      expansion_count{ 0 },
+      track_expansion{ false },
+      expansion_valid{ false }
+{
+  open_list.resize(static_cast<size_t>(height) * width);
+}
 
-void MazeModel::setController(MazeController *controller_ptr)
+void MazeModel::setController(MazeModelListener *controller_ptr)
 {
   this->controller_ptr = controller_ptr;
 }
 
 void MazeModel::emptyMap()
 {
-  for (auto &row : maze)
-    std::fill(row.begin(), row.end(), MazeElement::GROUND);
+  maze.fill(MazeElement::GROUND);
 }
 
 void MazeModel::resetMaze()
 {
-  for (int32_t y{}; y < MAZE_HEIGHT; ++y) {
-    for (int32_t x{}; x < MAZE_WIDTH; ++x) {
-      if (y == 0 || y == MAZE_HEIGHT - 1 || x == 0 || x == MAZE_WIDTH - 1)    // 上牆或下牆
+  MAZE_TRACE_SCOPE("resetMaze");
+  for (int32_t y{}; y < height; ++y) {
+    for (int32_t x{}; x < width; ++x) {
+      if (y == 0 || y == height - 1 || x == 0 || x == width - 1)    // 上牆或下牆
         maze[y][x] = MazeElement::WALL;
       else if (x % 2 == 1 && y % 2 == 1)    // xy 都為奇數的點當作GROUND
         maze[y][x] = MazeElement::GROUND;
@@ -40,14 +62,18 @@ void MazeModel::resetMaze()
     }
   }
 
-  controller_ptr->setFrameMaze(maze);
+  solve_overlay.clear();    // 整張圖都會換掉
+  if (controller_ptr) {
+    flushDiffs();
+    controller_ptr->setFrameMaze(maze);
+  }
 }
 
 void MazeModel::resetWallAroundMaze()
 {
-  for (int32_t y = 0; y < MAZE_HEIGHT; ++y) {
-    for (int32_t x = 0; x < MAZE_WIDTH; ++x) {
-      if (x == 0 || x == MAZE_WIDTH - 1 || y == 0 || y == MAZE_HEIGHT - 1)
+  for (int32_t y = 0; y < height; ++y) {
+    for (int32_t x = 0; x < width; ++x) {
+      if (x == 0 || x == width - 1 || y == 0 || y == height - 1)
         maze[y][x] = MazeElement::WALL;    // Wall
       else
         maze[y][x] = MazeElement::GROUND;    // Ground
@@ -57,27 +83,46 @@ void MazeModel::resetWallAroundMaze()
 
 /* --------------------maze generation methods -------------------- */
 
-void MazeModel::generateMazePrim()
+/**
+ * @brief Prim's algorithm on the reset grid, or continue the run of resume on the grid of its checkpoint
+ */
+MazeStats MazeModel::generateMazePrim(MazeGeneratorState *resume)
 {
-  std::mt19937 gen(std::chrono::high_resolution_clock::now().time_since_epoch().count());    // 產生亂數
-  std::array<int32_t, 4> direction_order{ 0, 1, 2, 3 };
-  std::vector<MazeNode> explored_cache;
-  std::vector<MazeNode> candidate_list;    // 待找的牆的列表
+  MAZE_TRACE_SCOPE("generateMazePrim");
+  MazeGeneratorState state = resume ? std::move(*resume) : MazeGeneratorState{};
+  MazeStats stats = state.stats;
+  const double resumed_ms = stats.elapsed_ms;    // 之前幾次執行花的時間
+  stats.start();
+  startCheckpoint();
+
+  clearOverlay();
+  std::mt19937 &gen = state.gen;    // 產生亂數
+  std::array<int32_t, 4> &direction_order = state.direction_order;
+  std::vector<MazeNode> &explored_cache = state.explored_cache;
+  std::vector<MazeNode> &candidate_list = state.frontier;    // 待找的牆的列表
+
+  if (!resume) {
+    state.algorithm = MazeAction::G_PRIMS;
+    gen = makeGenerator();
+    state.seed = last_seed;
 
-  {
     MazeNode seed_node;
-    setBeginPoint(seed_node);
+    setBeginPoint(seed_node, gen);
     explored_cache.emplace_back(seed_node);
+    ++stats.nodes_expanded;
 
     std::shuffle(direction_order.begin(), direction_order.end(), gen);
     for (const int32_t index : direction_order) {
       const auto [dir_y, dir_x] = dir_vec[index];
-      if (inMaze(seed_node, dir_y, dir_x))
+      if (inMaze(seed_node, dir_y, dir_x)) {
         candidate_list.emplace_back(MazeNode{ seed_node.y + dir_y, seed_node.x + dir_x, maze[seed_node.y + dir_y][seed_node.x + dir_x] });    // 將起點四周在迷宮內的牆加入 candidate_list 列表中
+        ++stats.pushes;
+      }
     }
+    stats.trackOpen(candidate_list.size(), sizeof(MazeNode), explored_cache.size() * sizeof(MazeNode));
   }
 
-  while (!candidate_list.empty()) {
+  while (!candidate_list.empty() && !isCancelled()) {
     std::uniform_int_distribution<> wall_dis(0, candidate_list.size() - 1);
     int32_t random_index = wall_dis(gen);
     MazeNode current_node = candidate_list[random_index];    // pick one point out
@@ -95,16 +140,20 @@ void MazeModel::generateMazePrim()
 
       // 如果左右都探索過了，或上下都探索過了，就把這個牆留著，並且加到確定是牆壁的 vector 裡
       if ((up_element == MazeElement::EXPLORED && down_element == MazeElement::EXPLORED) || (left_element == MazeElement::EXPLORED && right_element == MazeElement::EXPLORED)) {
-        candidate_list.erase(candidate_list.begin() + random_index);    // 如果「上下都走過」或「左右都走過」，那麼就把這個牆留著
+        std::swap(candidate_list[random_index], candidate_list.back());    // 如果「上下都走過」或「左右都走過」，那麼就把這個牆留著
+        candidate_list.pop_back();    // 清單是隨機抽的，順序不重要，和最後一個交換再刪掉是 O(1)
+        ++stats.pops;
       }
       else {
         // 不然就把牆打通
         current_node.element = MazeElement::EXPLORED;
         maze[current_node.y][current_node.x] = MazeElement::EXPLORED;
         explored_cache.emplace_back(current_node);
-        candidate_list.erase(candidate_list.begin() + random_index);
+        std::swap(candidate_list[random_index], candidate_list.back());
+        candidate_list.pop_back();
+        ++stats.pops;
 
-        controller_ptr->enFramequeue(current_node);
+        emitNode(current_node);
 
         if (up_element == MazeElement::EXPLORED && down_element == MazeElement::GROUND)    // 上面探索過，下面還沒
           ++current_node.y;    // 將目前的節點改成牆壁 "下面" 那個節點
@@ -122,43 +171,72 @@ void MazeModel::generateMazePrim()
         for (const int32_t index : direction_order) {    //(新的點的)上下左右遍歷
           const auto [dir_y, dir_x] = dir_vec[index];
           if (inMaze(current_node, dir_y, dir_x)) {    // 如果上(下左右)的牆在迷宮內
-            if (maze[current_node.y + dir_y][current_node.x + dir_x] == MazeElement::WALL)    // 而且如果這個節點是牆
+            if (maze[current_node.y + dir_y][current_node.x + dir_x] == MazeElement::WALL) {    // 而且如果這個節點是牆
               candidate_list.emplace_back(MazeNode{ current_node.y + dir_y, current_node.x + dir_x, maze[current_node.y + dir_y][current_node.x + dir_x] });    // 就將這個節點加入wall列表中
+              ++stats.pushes;
+            }
           }
         }
+        stats.nodes_expanded += 2;
+        stats.trackOpen(candidate_list.size(), sizeof(MazeNode), explored_cache.size() * sizeof(MazeNode));
 
-        controller_ptr->enFramequeue(current_node);
+        emitNode(current_node);
       }
     }
+
+    if (checkpointDue())
+      writeCheckpoint(state, stats, resumed_ms);
   }
 
-  controller_ptr->setModelComplete();
+  finishCheckpoint(state, stats, resumed_ms);
+  restoreExplored(explored_cache);
+  setFlag();
+  notifyComplete();
+
+  stats.stop();
+  stats.elapsed_ms += resumed_ms;
+  return stats;
 }    // end generateMazePrim()
 
-void MazeModel::generateMazeRecursionBacktracker()
+/**
+ * @brief recursive backtracker on the reset grid, or continue the run of resume on the grid of its checkpoint
+ */
+MazeStats MazeModel::generateMazeRecursionBacktracker(MazeGeneratorState *resume)
 {
-  struct TraceNode {
-    MazeNode node;
-    int8_t index = 0;
-    std::array<uint8_t, 4> direction_order = { 0, 1, 2, 3 };
-  };
-
-  std::mt19937 gen(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-  std::stack<TraceNode> explored_cache;    // 之後要改回道路的座標清單
-  std::stack<TraceNode> candidate_list;
-
-  {
-    TraceNode seed_node;
+  MAZE_TRACE_SCOPE("generateMazeRecursionBacktracker");
+  MazeGeneratorState state = resume ? std::move(*resume) : MazeGeneratorState{};
+  MazeStats stats = state.stats;
+  const double resumed_ms = stats.elapsed_ms;
+  stats.start();
+  startCheckpoint();
+
+  clearOverlay();
+  std::mt19937 &gen = state.gen;
+  std::vector<MazeNode> &explored_cache = state.explored_cache;    // 之後要改回道路的座標清單
+  std::vector<MazeTraceFrame> &candidate_list = state.stack;
+
+  if (!resume) {
+    state.algorithm = MazeAction::G_RECURSION_BACKTRACKER;
+    gen = makeGenerator();
+    state.seed = last_seed;
+
+    MazeTraceFrame seed_node;
     std::shuffle(seed_node.direction_order.begin(), seed_node.direction_order.end(), gen);
-    setBeginPoint(seed_node.node);
-    candidate_list.push(seed_node);
-    explored_cache.push(seed_node);
+    setBeginPoint(seed_node.node, gen);
+    candidate_list.push_back(seed_node);
+    explored_cache.emplace_back(seed_node.node);
+    ++stats.pushes;
+    ++stats.nodes_expanded;
   }
 
-  while (!candidate_list.empty()) {
-    TraceNode &current_node = candidate_list.top();
+  while (!candidate_list.empty() && !isCancelled()) {
+    if (checkpointDue())
+      writeCheckpoint(state, stats, resumed_ms);
+
+    MazeTraceFrame &current_node = candidate_list.back();
     if (current_node.index == 4) {
-      candidate_list.pop();
+      candidate_list.pop_back();
+      ++stats.pops;
       continue;
     }
 
@@ -169,357 +247,970 @@ void MazeModel::generateMazeRecursionBacktracker()
       continue;
 
     if (maze[current_node.node.y + 2 * dir_y][current_node.node.x + 2 * dir_x] == MazeElement::GROUND) {
-      TraceNode target_node{ { current_node.node.y + 2 * dir_y, current_node.node.x + 2 * dir_x, MazeElement::GROUND }, 0, { 0, 1, 2, 3 } };
+      MazeTraceFrame target_node{ { current_node.node.y + 2 * dir_y, current_node.node.x + 2 * dir_x, MazeElement::GROUND }, 0, { 0, 1, 2, 3 } };
       std::shuffle(target_node.direction_order.begin(), target_node.direction_order.end(), gen);
 
       current_node.node.element = MazeElement::EXPLORED;
       maze[current_node.node.y + dir_y][current_node.node.x + dir_x] = MazeElement::EXPLORED;
-      controller_ptr->enFramequeue(MazeNode{ current_node.node.y + dir_y, current_node.node.x + dir_x, MazeElement::EXPLORED });
-      explored_cache.emplace(TraceNode{ { current_node.node.y + dir_y, current_node.node.x + dir_x, MazeElement::EXPLORED }, 0, { 0, 1, 2, 3 } });
+      emitNode(MazeNode{ current_node.node.y + dir_y, current_node.node.x + dir_x, MazeElement::EXPLORED });
+      explored_cache.emplace_back(MazeNode{ current_node.node.y + dir_y, current_node.node.x + dir_x, MazeElement::EXPLORED });
 
       target_node.node.element = MazeElement::EXPLORED;
       maze[target_node.node.y][target_node.node.x] = MazeElement::EXPLORED;
-      controller_ptr->enFramequeue(target_node.node);
-      explored_cache.push(target_node);
+      emitNode(target_node.node);
+      explored_cache.emplace_back(target_node.node);
 
-      candidate_list.push(target_node);
+      candidate_list.push_back(target_node);
+      ++stats.pushes;
+      stats.nodes_expanded += 2;
+      stats.trackOpen(candidate_list.size(), sizeof(MazeTraceFrame), explored_cache.size() * sizeof(MazeNode));
     }
   }
 
-  controller_ptr->setModelComplete();
+  finishCheckpoint(state, stats, resumed_ms);
+  restoreExplored(explored_cache);
+  setFlag();
+  notifyComplete();
+
+  stats.stop();
+  stats.elapsed_ms += resumed_ms;
+  return stats;
 }    // end generateMazeRecursionBacktracker()
 
-void MazeModel::generateMazeRecursionDivision(const int32_t uy, const int32_t lx, const int32_t dy, const int32_t rx)
+/**
+ * @brief Growing Tree on the reset grid, Policy picks which active cell grows next
+ *
+ * The active set holds cell indices only, a cell with no uncarved neighbour left is removed in O(1). One random
+ * draw picks the neighbour among the open ones instead of shuffling the four directions every step.
+ */
+template <typename Policy>
+MazeStats MazeModel::generateMazeGrowingTree()
 {
-  std::mt19937 gen(std::chrono::high_resolution_clock::now().time_since_epoch().count());    // 產生亂數
-  int32_t width = rx - lx + 1, height = dy - uy + 1;
-  if (width < 2 && height < 2) return;
-  if (!inMaze(MazeNode{ uy, lx, MazeElement::INVALID }, height - 1, width - 1))
-    return;
+  MAZE_TRACE_SCOPE("generateMazeGrowingTree");
+  MazeStats stats;
+  stats.start();
+
+  clearOverlay();
+  std::mt19937 gen = makeGenerator();
+  std::vector<MazeNode> explored_cache;    // 之後要改回道路的座標清單
+  GrowingTreeActiveSet active_set;
+
+  MazeNode seed_node;
+  setBeginPoint(seed_node, gen);
+  explored_cache.emplace_back(seed_node);
+  active_set.push(static_cast<uint32_t>(cellIndex(seed_node.y, seed_node.x)));
+  ++stats.pushes;
+  ++stats.nodes_expanded;
+
+  while (!active_set.empty() && !isCancelled()) {
+    const size_t pos = Policy::select(active_set.size(), gen);
+    const uint32_t cell = active_set[pos];
+    const MazeNode current_node{ static_cast<int32_t>(cell / width), static_cast<int32_t>(cell % width), MazeElement::EXPLORED };
+
+    int32_t open_dirs[4];
+    int32_t open_count = 0;
+    for (int32_t dir = 0; dir < 4; ++dir) {
+      const auto [dir_y, dir_x] = dir_vec[dir];
+      if (inMaze(current_node, 2 * dir_y, 2 * dir_x) && maze[current_node.y + 2 * dir_y][current_node.x + 2 * dir_x] == MazeElement::GROUND)
+        open_dirs[open_count++] = dir;
+    }
+
+    if (open_count == 0) {
+      active_set.erase(pos, !Policy::reads_front);    // 四周都挖過了，這格不會再長
+      ++stats.pops;
+      continue;
+    }
+
+    const int32_t dir = open_count == 1 ? open_dirs[0] : open_dirs[std::uniform_int_distribution<int32_t>(0, open_count - 1)(gen)];
+    const auto [dir_y, dir_x] = dir_vec[dir];
+    const MazeNode wall_node{ current_node.y + dir_y, current_node.x + dir_x, MazeElement::EXPLORED };
+    const MazeNode target_node{ current_node.y + 2 * dir_y, current_node.x + 2 * dir_x, MazeElement::EXPLORED };
+
+    maze[wall_node.y][wall_node.x] = MazeElement::EXPLORED;
+    emitNode(wall_node);
+    explored_cache.emplace_back(wall_node);
 
-  bool is_horizontal = (width <= height) ? true : false;
-  int32_t wall_index;
-  if (is_horizontal && height - 2 > 0) {
-    std::uniform_int_distribution<> h_dis(uy + 1, uy + height - 2);
-    wall_index = h_dis(gen);
-    for (int32_t i = lx; i <= rx; ++i) maze[wall_index][i] = MazeElement::WALL;    // 將這段距離都設圍牆壁
+    maze[target_node.y][target_node.x] = MazeElement::EXPLORED;
+    emitNode(target_node);
+    explored_cache.emplace_back(target_node);
 
-    generateMazeRecursionDivision(uy, lx, wall_index - 1, rx);    // 上面
-    generateMazeRecursionDivision(wall_index + 1, lx, dy, rx);    // 下面
+    active_set.push(static_cast<uint32_t>(cellIndex(target_node.y, target_node.x)));
+    ++stats.pushes;
+    stats.nodes_expanded += 2;
+    stats.trackOpen(active_set.size(), sizeof(uint32_t), explored_cache.size() * sizeof(MazeNode));
   }
-  else if (!is_horizontal && width - 2 > 0) {
-    std::uniform_int_distribution<> w_dis(lx + 1, lx + width - 2);
-    wall_index = w_dis(gen);
-    for (int32_t i = uy; i <= dy; ++i) maze[i][wall_index] = MazeElement::WALL;    // 將這段距離都設圍牆壁
 
-    generateMazeRecursionDivision(uy, lx, dy, wall_index - 1);    // 左邊
-    generateMazeRecursionDivision(uy, wall_index + 1, dy, rx);    // 右邊
+  restoreExplored(explored_cache);
+  setFlag();
+  notifyComplete();
+
+  stats.stop();
+  return stats;
+}    // end generateMazeGrowingTree()
+
+template MazeStats MazeModel::generateMazeGrowingTree<GrowingTreeNewest>();
+template MazeStats MazeModel::generateMazeGrowingTree<GrowingTreeRandom>();
+template MazeStats MazeModel::generateMazeGrowingTree<GrowingTreeOldest>();
+template MazeStats MazeModel::generateMazeGrowingTree<GrowingTreeMix<GrowingTreeNewest, GrowingTreeRandom, 75>>();
+
+MazeStats MazeModel::generateMazeRecursionDivision()
+{
+  MAZE_TRACE_SCOPE("generateMazeRecursionDivision");
+  MazeStats stats;
+  stats.start();
+
+  std::mt19937 gen = makeGenerator();    // 產生亂數
+  resetWallAroundMaze();
+  solve_overlay.clear();
+  if (controller_ptr) {
+    flushDiffs();
+    controller_ptr->setFrameMaze(maze);    // 先把空的房間交給畫面，之後的牆一道一道送過去
   }
-  else
-    return;
 
-  int32_t path_index;
-  if (is_horizontal) {
-    while (true) {
-      std::uniform_int_distribution<> w_dis(lx, lx + width - 1);
-      path_index = w_dis(gen);
-      // if (maze[wall_index - 1][path_index] + maze[wall_index + 1][path_index] + maze[wall_index][path_index - 1] + maze[wall_index][path_index + 1] <= 2 * MazeElement::WALL) break;
-    }
-    maze[wall_index][path_index] = MazeElement::GROUND;
+  divideChamber(1, 1, height - 2, width - 2, 1, gen, stats);
+  setFlag();
+  notifyComplete();
+
+  stats.stop();
+  return stats;
+}    // end generateMazeRecursionDivision()
+
+/**
+ * @brief split the chamber [uy, dy] x [lx, rx] with one wall that has a single gap, then recurse into both halves
+ *
+ * The chamber bounds are odd, walls are placed on even rows/columns and gaps on odd ones,
+ * so the walls of the sub-chambers can never block a gap.
+ */
+void MazeModel::divideChamber(const int32_t uy, const int32_t lx, const int32_t dy, const int32_t rx, const uint64_t depth, std::mt19937 &gen, MazeStats &stats)
+{
+  if (isCancelled())
+    return;
+  stats.trackOpen(depth, sizeof(MazeNode), 0);    // 遞迴深度就是 open list 的長度
+
+  const int32_t chamber_width = rx - lx + 1, chamber_height = dy - uy + 1;
+  const bool is_horizontal = (chamber_width <= chamber_height) ? true : false;
+
+  if (is_horizontal && chamber_height >= 3) {
+    std::uniform_int_distribution<> h_dis(0, (chamber_height - 3) / 2);
+    std::uniform_int_distribution<> w_dis(0, (chamber_width - 1) / 2);
+    const int32_t wall_index = uy + 1 + 2 * h_dis(gen);
+    const int32_t path_index = lx + 2 * w_dis(gen);
+    for (int32_t i = lx; i <= rx; ++i)    // 將這段距離都設圍牆壁，留一個洞
+      if (i != path_index) maze[wall_index][i] = MazeElement::WALL;
+    emitSpan(wall_index, lx, path_index - lx, MazeElement::WALL);    // 洞的左右兩段各送一個 span
+    emitSpan(wall_index, path_index + 1, rx - path_index, MazeElement::WALL);
+
+    ++stats.nodes_expanded;
+    divideChamber(uy, lx, wall_index - 1, rx, depth + 1, gen, stats);    // 上面
+    divideChamber(wall_index + 1, lx, dy, rx, depth + 1, gen, stats);    // 下面
   }
-  else {
-    while (true) {
-      std::uniform_int_distribution<> h_dis(uy, uy + height - 1);
-      path_index = h_dis(gen);
-      // if (maze[path_index - 1][wall_index] + maze[path_index + 1][wall_index] + maze[path_index][wall_index - 1] + maze[path_index][wall_index + 1] <= 2 * MazeElement::WALL) break;
+  else if (!is_horizontal && chamber_width >= 3) {
+    std::uniform_int_distribution<> w_dis(0, (chamber_width - 3) / 2);
+    std::uniform_int_distribution<> h_dis(0, (chamber_height - 1) / 2);
+    const int32_t wall_index = lx + 1 + 2 * w_dis(gen);
+    const int32_t path_index = uy + 2 * h_dis(gen);
+    for (int32_t i = uy; i <= dy; ++i) {    // 將這段距離都設圍牆壁，留一個洞
+      if (i == path_index) continue;
+      maze[i][wall_index] = MazeElement::WALL;
+      emitNode(MazeNode{ i, wall_index, MazeElement::WALL });
     }
-    maze[path_index][wall_index] = MazeElement::GROUND;
+
+    ++stats.nodes_expanded;
+    divideChamber(uy, lx, dy, wall_index - 1, depth + 1, gen, stats);    // 左邊
+    divideChamber(uy, wall_index + 1, dy, rx, depth + 1, gen, stats);    // 右邊
   }
-}    // end generateMazeRecursionDivision()
+}    // end divideChamber()
 
 /* --------------------maze solving methods -------------------- */
 
-bool MazeModel::solveMazeDFS(const int32_t y, const int32_t x)
+MazeStats MazeModel::solveMazeDFS()
 {
-  maze[1][0] = MazeElement::BEGIN;    // 起點
-  maze[y][x] = MazeElement::EXPLORED;    // 探索過的點
+  struct TraceNode {
+    int32_t y, x;
+    int8_t index = 0;    // 下一個要走的方向
+  };
 
-  if (y == END_Y && x == END_X) {    // 如果到終點了就回傳True
-    maze[y][x] = MazeElement::END;    // 終點
+  MAZE_TRACE_SCOPE("solveMazeDFS");
+  MazeStats stats;
+  stats.start();
+
+  nextVisitEpoch();
+  clearOverlay();
+
+  std::stack<TraceNode> result;    // 用 stack 取代遞迴，大地圖才不會把 call stack 用完
+  result.push(TraceNode{ begin_y, begin_x, 0 });
+  setVisited(begin_y, begin_x, cellIndex(begin_y, begin_x));    // 起點
+  ++stats.pushes;
+
+  while (!result.empty() && !isCancelled()) {
+    TraceNode &current_node = result.top();
+    if (current_node.index == 0) {    // 第一次走到這個點
+      ++stats.nodes_expanded;
+      markExpanded(current_node.y, current_node.x);
+      if (current_node.y == end_y && current_node.x == end_x) {    // 如果到終點了就結束
+        stats.path_length = tracePath(end_y, end_x);
+        emitPath(end_y, end_x);
+        break;
+      }
+    }
 
-    return true;
-  }
-  for (const auto &[dir_y, dir_x] : dir_vec) {    // 上下左右
-    const int32_t temp_y = y + dir_y, temp_x = x + dir_x;
-    if (is_in_maze(temp_y, temp_x)) {    // 如果這個節點在迷宮內
-      if (maze[temp_y][temp_x] == MazeElement::GROUND)    // 而且如果這個節點還沒被探索過
-        if (solveMazeDFS(temp_y, temp_x))    // 就繼續遞迴，如果已經找到目標就會回傳 true ，所以這裡放在 if 裡面
-          return true;
+    if (current_node.index == 4) {    // 上下左右都走過了就往回
+      result.pop();
+      ++stats.pops;
+      continue;
+    }
+
+    const auto [dir_y, dir_x] = dir_vec[current_node.index++];
+    const int32_t y = current_node.y + dir_y, x = current_node.x + dir_x;
+    if (isPassable(y, x) && !isVisited(y, x)) {    // 如果這個節點在迷宮內，而且還沒被探索過
+      setVisited(y, x, cellIndex(current_node.y, current_node.x));
+      result.push(TraceNode{ y, x, 0 });
+      ++stats.pushes;
+      stats.trackOpen(result.size(), sizeof(TraceNode), searchMemory());
     }
   }
-  return false;
+
+  stats.stop();
+  return stats;
 }    // end solveMazeDFS()
 
-void MazeModel::solveMazeBFS()
+MazeStats MazeModel::solveMazeBFS()
 {
+  MAZE_TRACE_SCOPE("solveMazeBFS");
+  MazeStats stats;
+  stats.start();
+
+  nextVisitEpoch();
+  clearOverlay();
+
   std::queue<std::pair<int32_t, int32_t>> result;    // 存節點的 qeque
-  result.push(std::make_pair(BEGIN_Y, BEGIN_X));    // 將一開始的節點加入 qeque
-  maze[BEGIN_Y][BEGIN_X] = MazeElement::BEGIN;    // 起點
+  result.push(std::make_pair(begin_y, begin_x));    // 將一開始的節點加入 qeque
+  setVisited(begin_y, begin_x, cellIndex(begin_y, begin_x));    // 起點
+  ++stats.pushes;
 
 
-  while (!result.empty()) {
+  while (!result.empty() && !isCancelled()) {
     const auto [temp_y, temp_x]{ result.front() };    // 目前的節點
     result.pop();    // 將目前的節點拿出來
+    ++stats.pops;
+    ++stats.nodes_expanded;
+    markExpanded(temp_y, temp_x);
 
     for (const auto &dir : dir_vec) {    // 遍歷上下左右
       const int32_t y = temp_y + dir.first, x = temp_x + dir.second;    // 上下左右的節點
 
-      if (is_in_maze(y, x)) {    // 如果這個節點在迷宮內
-        if (maze[y][x] == MazeElement::GROUND) {    // 而且如果這個節點還沒被探索過，也不是牆壁
-          maze[y][x] = MazeElement::EXPLORED;    // 那就探索他，改 EXPLORED
-
-          if (y == END_Y && x == END_X) {    // 找到終點就return
-            maze[y][x] = MazeElement::END;    // 終點
+      if (isPassable(y, x) && !isVisited(y, x)) {    // 如果這個節點在迷宮內，還沒被探索過，也不是牆壁
+        setVisited(y, x, cellIndex(temp_y, temp_x));    // 那就探索他
 
-            return;
-          }
-          else
-            result.push(std::make_pair(y, x));    // 沒找到節點就加入節點
+        if (y == end_y && x == end_x) {    // 找到終點就return
+          stats.path_length = tracePath(y, x);
+          emitPath(y, x);
+          stats.stop();
+          return stats;
+        }
+        else {
+          result.push(std::make_pair(y, x));    // 沒找到節點就加入節點
+          ++stats.pushes;
         }
       }
     }
+    stats.trackOpen(result.size(), sizeof(std::pair<int32_t, int32_t>), searchMemory());
   }    // end while
+
+  stats.stop();
+  return stats;
 }    // end solveMazeBFS()
 
-void MazeModel::solveMazeUCS(const MazeAction actions)
+MazeStats MazeModel::solveMazeUCS(const MazeAction actions)
 {
-  struct Node {
-    int32_t __Weight;    // 權重 (Cost Function)
-    int32_t y;    // y座標
-    int32_t x;    // x座標
-    Node(int32_t weight, int32_t y, int32_t x) : __Weight(weight), y(y), x(x) {}
-    bool operator>(const Node &other) const { return __Weight > other.__Weight; }    // priority比大小只看權重
-    bool operator<(const Node &other) const { return __Weight < other.__Weight; }    // priority比大小只看權重
+  MAZE_TRACE_SCOPE("solveMazeUCS");
+  MazeStats stats;
+  stats.start();
+
+  nextVisitEpoch();
+  clearOverlay();
+  open_list.clear();
+
+  const int32_t interval_y = std::max(height / 10, 1), interval_x = std::max(width / 10, 1);    // 分 10 個區間
+  const auto step_weight = [&](const int32_t y, const int32_t x) -> int64_t {
+    switch (actions) {
+    case MazeAction::S_UCS_MANHATTAN:
+      return abs(end_x - x) + abs(end_y - y);    // 權重為曼哈頓距離
+    case MazeAction::S_UCS_TWO_NORM:
+      return pow_two_norm(y, x);    // 權重為 Two_Norm
+    default:
+      // 權重以區間計算，兩個相除是看它在第幾個區間，然後用總區間數減掉，代表它的基礎權重
+      return (static_cast<int32_t>(y / interval_y) < static_cast<int32_t>(x / interval_x)) ? (10 - static_cast<int32_t>(y / interval_y)) : (10 - static_cast<int32_t>(x / interval_x));
+    }
   };
 
-  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> result;    // 待走的結點，greater代表小的會在前面，由小排到大
-  int32_t weight{};    // 用來計算的權重
+  const size_t begin_index = cellIndex(begin_y, begin_x);
+  parent[begin_index] = static_cast<uint32_t>(begin_index);
+  open_list.pushOrDecrease(static_cast<uint32_t>(begin_index), step_weight(begin_y, begin_x));    // 將起點加進去
+  ++stats.pushes;
+
+  while (!open_list.empty() && !isCancelled()) {
+    const auto temp = open_list.pop();    // 目前最優先的結點，每個格子只會在 heap 裡出現一次
+    ++stats.pops;
+    const int32_t temp_y = static_cast<int32_t>(temp.id / width), temp_x = static_cast<int32_t>(temp.id % width);
+    setVisited(temp_y, temp_x, parent[temp.id]);    // 探索過的點標記起來，maze 本身不動
+
+    if (temp_y == end_y && temp_x == end_x) {
+      stats.path_length = tracePath(temp_y, temp_x);
+      emitPath(temp_y, temp_x);
+      break;    // 如果取出的點是終點就結束
+    }
+    ++stats.nodes_expanded;
+    markExpanded(temp_y, temp_x);
+
+    for (const auto &dir : dir_vec) {
+      const int32_t y = temp_y + dir.first, x = temp_x + dir.second;
+
+      if (isPassable(y, x) && !isVisited(y, x)) {    // 如果這個結點還沒走過，就把他加到待走的結點裡，或是更新成比較小的權重
+        const uint32_t index = static_cast<uint32_t>(cellIndex(y, x));
+        const bool is_new = !open_list.contains(index);
+        if (open_list.pushOrDecrease(index, temp.key + step_weight(y, x))) {
+          parent[index] = temp.id;
+          stats.pushes += is_new;
+        }
+      }
+    }    // end for
+    stats.trackOpen(open_list.size(), sizeof(IndexedHeap<int64_t>::Entry), searchMemory());
+  }    // end while
 
-  switch (actions) {    // 起點
-  case MazeAction::S_UCS_MANHATTAN:
-    weight = abs(END_X - BEGIN_X) + abs(END_Y - BEGIN_Y);    // 權重為曼哈頓距離
-    break;
-  case MazeAction::S_UCS_TWO_NORM:
-    weight = pow_two_norm(BEGIN_Y, BEGIN_X);    // 權重為 two_norm
-    break;
-  case MazeAction::S_UCS_INTERVAL:
-    constexpr int32_t interval_y = MAZE_HEIGHT / 10, interval_x = MAZE_WIDTH / 10;    // 分 10 個區間
-    weight = (static_cast<int32_t>(BEGIN_Y / interval_y) < static_cast<int32_t>(BEGIN_X / interval_x)) ? (10 - static_cast<int32_t>(BEGIN_Y / interval_y)) : (10 - static_cast<int32_t>(BEGIN_X / interval_x));    // 權重以區間計算，兩個相除是看它在第幾個區間，然後用總區間數減掉，代表它的基礎權重，再乘以1000
-    break;
-  }
+  stats.stop();
+  return stats;
+}    // end solveMazeUCS()
 
-  result.push(Node(weight, BEGIN_Y, BEGIN_Y));    // 將起點加進去
+MazeStats MazeModel::solveMazeGreedy()
+{
+  MAZE_TRACE_SCOPE("solveMazeGreedy");
+  MazeStats stats;
+  stats.start();
+
+  nextVisitEpoch();
+  clearOverlay();
+  open_list.clear();
+
+  // 權重為 Two_Norm 平方 (Heuristic function)，只和格子本身有關，所以一個格子進 heap 之後權重不會再變
+  const size_t begin_index = cellIndex(begin_y, begin_x);
+  parent[begin_index] = static_cast<uint32_t>(begin_index);
+  open_list.pushOrDecrease(static_cast<uint32_t>(begin_index), pow_two_norm(begin_y, begin_x));    // 將起點加進去
+  ++stats.pushes;
+
+  while (!open_list.empty() && !isCancelled()) {
+    const auto temp = open_list.pop();    // 目前最優先的結點
+    ++stats.pops;
+    const int32_t temp_y = static_cast<int32_t>(temp.id / width), temp_x = static_cast<int32_t>(temp.id % width);
+    setVisited(temp_y, temp_x, parent[temp.id]);    // 探索過的點標記起來，maze 本身不動
+
+    if (temp_y == end_y && temp_x == end_x) {
+      stats.path_length = tracePath(temp_y, temp_x);
+      emitPath(temp_y, temp_x);
+      break;    // 如果取出的點是終點就結束
+    }
+    ++stats.nodes_expanded;
+    markExpanded(temp_y, temp_x);
 
-  while (true) {
-    if (result.empty())
-      return;    // 沒找到目標
+    for (const auto &dir : dir_vec) {
+      const int32_t y = temp_y + dir.first, x = temp_x + dir.second;
 
-    const auto temp = result.top();    // 目前最優先的結點
-    result.pop();    // 取出結點判斷
+      if (isPassable(y, x) && !isVisited(y, x)) {    // 如果這個結點還沒走過，就把他加到待走的結點裡
+        const uint32_t index = static_cast<uint32_t>(cellIndex(y, x));
+        if (open_list.pushOrDecrease(index, pow_two_norm(y, x))) {
+          parent[index] = temp.id;
+          ++stats.pushes;
+        }
+      }
+    }
+    stats.trackOpen(open_list.size(), sizeof(IndexedHeap<int64_t>::Entry), searchMemory());
+  }    // end while
 
-    if (temp.y == END_Y && temp.x == END_X) {
-      maze[temp.y][temp.x] = MazeElement::END;    // 終點
+  stats.stop();
+  return stats;
+}    // end solveMazeGreedy()
 
-      return;    // 如果取出的點是終點就return
-    }
-    else if (maze[temp.y][temp.x] == MazeElement::GROUND) {
-      if (temp.y == BEGIN_Y && temp.x == BEGIN_X)
-        maze[temp.y][temp.x] = MazeElement::BEGIN;    // 起點
-      else {
-        maze[temp.y][temp.x] = MazeElement::EXPLORED;    // 探索過的點要改EXPLORED
-      }
+MazeStats MazeModel::solveMazeAStar(const MazeAction actions)
+{
+  MAZE_TRACE_SCOPE("solveMazeAStar");
+  MazeStats stats;
+  stats.start();
+
+  nextVisitEpoch();
+  clearOverlay();
+  open_list.clear();
+
+  // S_ASTAR：Cost Function 為常數 50，Heuristic Function 為曼哈頓距離
+  // S_ASTAR_INTERVAL：Cost 以區間計算，每一個區間 Cost 差 8，距離終點越遠 Cost 越大，Heuristic Function 為 Two_Norm 平方
+  const bool is_interval = (actions == MazeAction::S_ASTAR_INTERVAL);
+  const int32_t interval_y = std::max(height / 10, 1), interval_x = std::max(width / 10, 1);    // 分 10 個區間
+  const auto heuristic = [&](const int32_t y, const int32_t x) -> int64_t {
+    return is_interval ? pow_two_norm(y, x) : abs(end_x - x) + abs(end_y - y);
+  };
+  const auto step_cost = [&](const int32_t y, const int32_t x) -> int64_t {
+    if (!is_interval)
+      return 50;
+    // Cost 以區間計算，兩個相除是看它在第幾個區間，然後用總區間數減掉，代表它的基礎 Cost，再乘以8
+    return (static_cast<int32_t>(y / interval_y) < static_cast<int32_t>(x / interval_x)) ? (10 - static_cast<int32_t>(y / interval_y)) * 8 : (10 - static_cast<int32_t>(x / interval_x)) * 8;
+  };
 
-      for (const auto &dir : dir_vec) {
-        const int32_t y = temp.y + dir.first, x = temp.x + dir.second;
-
-        if (is_in_maze(y, x)) {
-          if (maze[y][x] == MazeElement::GROUND) {    // 如果這個結點還沒走過，就把他加到待走的結點裡
-            switch (actions) {
-            case MazeAction::S_UCS_MANHATTAN:
-              weight = abs(END_X - x) + abs(END_Y - y);    // 權重為曼哈頓距離
-              break;
-            case MazeAction::S_UCS_TWO_NORM:
-              weight = pow_two_norm(y, x);    // 權重為 Two_Norm
-              break;
-            case MazeAction::S_UCS_INTERVAL:
-              constexpr int32_t interval_y = MAZE_HEIGHT / 10, interval_x = MAZE_WIDTH / 10;    // 分 10 個區間
-              weight = (static_cast<int32_t>(y / interval_y) < static_cast<int32_t>(x / interval_x)) ? (10 - static_cast<int32_t>(y / interval_y)) : (10 - static_cast<int32_t>(x / interval_x));    // 權重為區間
-              break;
-            }
-            result.push(Node(temp.__Weight + weight, y, x));    // 加入節點
-          }
+  // heap 的 key 是 cost + heuristic，heuristic 只和格子本身有關，所以 cost 可以從 key 算回來，不用另外存
+  const size_t begin_index = cellIndex(begin_y, begin_x);
+  parent[begin_index] = static_cast<uint32_t>(begin_index);
+  open_list.pushOrDecrease(static_cast<uint32_t>(begin_index), step_cost(begin_y, begin_x) + heuristic(begin_y, begin_x));    // 將起點加進去
+  ++stats.pushes;
+
+  while (!open_list.empty() && !isCancelled()) {
+    const auto temp = open_list.pop();    // 目前最優先的結點
+    ++stats.pops;
+    const int32_t temp_y = static_cast<int32_t>(temp.id / width), temp_x = static_cast<int32_t>(temp.id % width);
+    setVisited(temp_y, temp_x, parent[temp.id]);    // 探索過的點標記起來，maze 本身不動
+
+    if (temp_y == end_y && temp_x == end_x) {
+      stats.path_length = tracePath(temp_y, temp_x);
+      emitPath(temp_y, temp_x);
+      break;    // 如果取出的點是終點就結束
+    }
+    ++stats.nodes_expanded;
+    markExpanded(temp_y, temp_x);
+
+    const int64_t temp_cost = is_interval ? temp.key - heuristic(temp_y, temp_x) : 0;    // 常數 Cost 不累加
+    for (const auto &dir : dir_vec) {
+      const int32_t y = temp_y + dir.first, x = temp_x + dir.second;
+
+      if (isPassable(y, x) && !isVisited(y, x)) {    // 如果這個結點還沒走過，就把他加到待走的結點裡，或是更新成比較小的權重
+        const uint32_t index = static_cast<uint32_t>(cellIndex(y, x));
+        const bool is_new = !open_list.contains(index);
+        if (open_list.pushOrDecrease(index, temp_cost + step_cost(y, x) + heuristic(y, x))) {
+          parent[index] = temp.id;
+          stats.pushes += is_new;
         }
-      }    // end for
+      }
     }
+    stats.trackOpen(open_list.size(), sizeof(IndexedHeap<int64_t>::Entry), searchMemory());
   }    // end while
-}    // end solveMazeUCS()
 
-void MazeModel::solveMazeGreedy()
+  stats.stop();
+  return stats;
+}    // end solveMazeAStar()
+
+/**
+ * @brief the generators and solvers poll the token and stop early once it is set, nullptr means never cancelled
+ */
+void MazeModel::setCancelToken(const std::atomic<bool> *token)
 {
-  struct Node {
-    int32_t __Weight;    // 權重為 Two_Norm 平方 (Heuristic function)
-    int32_t y;    // y座標
-    int32_t x;    // x座標
-    Node(int32_t weight, int32_t y, int32_t x) : __Weight(weight), y(y), x(x) {}
-    bool operator>(const Node &other) const { return __Weight > other.__Weight; }    // priority比大小只看權重
-    bool operator<(const Node &other) const { return __Weight < other.__Weight; }    // priority比大小只看權重
-  };
+  cancel_token = token;
+}
 
-  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> result;    // 待走的結點，greater代表小的會在前面，由小排到大
-  result.push(Node(pow_two_norm(BEGIN_Y, BEGIN_X), BEGIN_Y, BEGIN_X));    // 將起點加進去
+/**
+ * @brief drop every pending diff and overlay and send the whole grid again, after a cancelled job left the view behind
+ */
+void MazeModel::resyncView()
+{
+  pending_diffs.clear();
+  solve_overlay.clear();
+  if (controller_ptr)
+    controller_ptr->setFrameMaze(maze);
+}
 
-  while (true) {
-    if (result.empty())
-      return;    // 沒找到目標
-    const auto temp = result.top();    // 目前最優先的結點
-    result.pop();    // 取出結點判斷
+/**
+ * @brief write the current maze with its seed, generator and begin / end points
+ */
+bool MazeModel::saveMaze(const std::string &path, const MazeEncoding encoding)
+{
+  MazeFileInfo info;
+  info.encoding = encoding;
+  info.seed = last_seed;
+  info.algorithm = last_generator;
+  info.has_endpoints = true;
+  info.begin_y = begin_y, info.begin_x = begin_x;
+  info.end_y = end_y, info.end_x = end_x;
+  return MazeFile::save(path, maze, info);
+}
 
-    if (temp.y == END_Y && temp.x == END_X) {
-      maze[temp.y][temp.x] = MazeElement::END;    // 終點
+/**
+ * @brief replace the maze with the one in the file, a BYTE file is used in place through its mapping, BIT / RLE files
+ * are decoded on the thread pool
+ *
+ * The search buffers are only allocated by the first solver that runs, so opening a huge maze costs nothing
+ * until it is actually solved. Files without begin / end points use the default corners. A file whose checksum does
+ * not match is refused, checking it reads the whole file once.
+ */
+bool MazeModel::loadMaze(const std::string &path, const bool verify_checksum)
+{
+  MAZE_TRACE_SCOPE("loadMaze");
+  MazeFile file;
+  if (!file.open(path) || (verify_checksum && !file.verify()))
+    return false;
+
+  MazeGrid grid = file.grid(controller_ptr ? &controller_ptr->threadPool() : nullptr);
+  if (grid.empty())
+    return false;
+
+  const MazeFileInfo &info = file.info();
+  if (info.has_endpoints ? !setMaze(std::move(grid), info.begin_y, info.begin_x, info.end_y, info.end_x) : !setMaze(std::move(grid)))
+    return false;
+  last_seed = info.seed;
+  last_generator = info.algorithm;
+  return true;
+}
 
-      return;    // 如果取出的點是終點就return
-    }
-    else if (maze[temp.y][temp.x] == MazeElement::GROUND) {
-      if (temp.y == BEGIN_Y && temp.x == BEGIN_X)
-        maze[temp.y][temp.x] = MazeElement::BEGIN;    // 起點
-      else {
-        maze[temp.y][temp.x] = MazeElement::EXPLORED;    // 探索過的點要改EXPLORED
-      }
+/**
+ * @brief replace the maze with grid of any size and show it, the search buffers follow on the next search
+ *
+ * Negative begin / end coordinates pick the default corners, (1, 0) and (height - 2, width - 1). A grid with more
+ * cells than MAX_MAZE_CELLS is refused and the current maze is kept, the cell indices are 32-bit.
+ */
+bool MazeModel::setMaze(MazeGrid grid, const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x)
+{
+  if (!fitsCellIndex(grid.height(), grid.width())) {
+    std::clog << grid.height() << 'x' << grid.width() << " maze has more cells than a 32-bit cell index can address" << std::endl;
+    return false;
+  }
 
-      for (const auto &dir : dir_vec) {
-        const int32_t y = temp.y + dir.first, x = temp.x + dir.second;
+  maze = std::move(grid);
+  height = maze.height(), width = maze.width();
+  this->begin_y = begin_y >= 0 ? begin_y : std::min(BEGIN_Y, height - 1);
+  this->begin_x = begin_x >= 0 ? begin_x : BEGIN_X;
+  this->end_y = end_y >= 0 ? end_y : std::max(height - 2, 0);
+  this->end_x = end_x >= 0 ? end_x : width - 1;
+  last_seed = 0;
+  last_generator = MazeAction::G_RESET;
+  expansion_valid = false;
+
+  pending_diffs.clear();
+  solve_overlay.clear();
+  if (controller_ptr)
+    controller_ptr->setFrameMaze(maze);
+  return true;
+}
 
-        if (is_in_maze(y, x)) {
-          if (maze[y][x] == MazeElement::GROUND)    // 如果這個結點還沒走過，就把他加到待走的結點裡
-            result.push(Node(pow_two_norm(y, x), y, x));
-        }
-      }
-    }
-  }    // end while
-}    // end solveMazeGreedy()
+/**
+ * @brief move the points the solvers search between, the cells of the maze are not touched
+ *
+ * For running many queries on the same maze (benchmark scenarios), the view is not told about it.
+ */
+void MazeModel::setEndpoints(const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x)
+{
+  this->begin_y = begin_y, this->begin_x = begin_x;
+  this->end_y = end_y, this->end_x = end_x;
+}
+
+/**
+ * @brief the cells the last solver painted sorted by index, a cell painted twice keeps its later element last
+ */
+MazeOverlay MazeModel::solutionOverlay() const
+{
+  MazeOverlay overlay = solve_overlay;
+  std::stable_sort(overlay.begin(), overlay.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  return overlay;
+}
 
-void MazeModel::solveMazeAStar(const MazeAction actions)
+/**
+ * @brief checkpoint Prim and the backtracker to path every interval_seconds while they run, an empty path turns it off
+ *
+ * A run that finishes removes its checkpoint, a cancelled one writes a last checkpoint so it can be resumed.
+ */
+void MazeModel::setCheckpoint(const std::string &path, const double interval_seconds)
 {
-  enum class Types : int32_t {
-    Normal = 0,    // Cost Function 為 50
-    Interval = 1,    // Cost Function 以區間來計算，每一個區間 Cost 差10，距離終點越遠 Cost 越大
-  };
+  checkpoint_path = path;
+  checkpoint_seconds = std::max(interval_seconds, 0.0);
+}
+
+/**
+ * @brief load the checkpoint at path and continue its generation to the end
+ *
+ * The grid, begin / end points and seed of the checkpoint replace the current maze, and the maze that comes out is the
+ * same one an uninterrupted run with that seed would have made. Returns nullopt if the file is missing or invalid.
+ */
+std::optional<MazeStats> MazeModel::resumeGeneration(const std::string &path)
+{
+  MAZE_TRACE_SCOPE("resumeGeneration");
+  MazeGeneratorState state;
+  MazeGrid grid;
+  int32_t by, bx, ey, ex;
+  if (!MazeCheckpoint::load(path, state, grid, by, bx, ey, ex))
+    return std::nullopt;
+
+  if (!setMaze(std::move(grid), by, bx, ey, ex))
+    return std::nullopt;
+  last_seed = state.seed;
+  const MazeAction algorithm = state.algorithm;
+  const MazeStats stats = algorithm == MazeAction::G_PRIMS ? generateMazePrim(&state) : generateMazeRecursionBacktracker(&state);
+  last_generator = algorithm;
+  if (!isCancelled())
+    std::remove(path.c_str());    // 跑完了，沒有東西可以接著跑
+
+  flushDiffs();
+  return stats;
+}
 
-  struct Node {
-    int32_t __Cost;    // Cost Function 有兩種，以區間計算，每個區間 Cost 差10
-    int32_t __Weight;    // 權重以區間(Cost Function) + Two_Norm 平方(Heuristic Function) 計算，每個區間 Cost 差1000
-    int32_t y;    // y座標
-    int32_t x;    // x座標
-    Node(int32_t cost, int32_t weight, int32_t y, int32_t x) : __Cost(cost), __Weight(weight), y(y), x(x) {}
-    bool operator>(const Node &other) const { return __Weight > other.__Weight; }    // priority比大小只看權重
-    bool operator<(const Node &other) const { return __Weight < other.__Weight; }    // priority比大小只看權重
+/**
+ * @brief record the expansion index of every cell the solvers expand, costs one uint32_t per cell while enabled
+ */
+void MazeModel::setExpansionTracking(const bool enable)
+{
+  track_expansion = enable;
+}
+
+/**
+ * @brief the expansion index of every cell in the last search, empty if it was not tracked or the maze changed since
+ *
+ * The index counts from 1 in the order the solver expanded the cells, the same count as MazeStats::nodes_expanded.
+ * Rows are gathered on the thread pool.
+ */
+MazeExpansionLayer MazeModel::expansionLayer() const
+{
+  MAZE_TRACE_SCOPE("expansionLayer");
+  MazeExpansionLayer layer;
+  if (!expansion_valid || expansion.size() != maze.size())
+    return layer;
+
+  layer.height = height, layer.width = width;
+  layer.expanded = expansion_count;
+  layer.order.resize(maze.size());
+  const auto gather = [&](const size_t row_begin, const size_t row_end) {
+    for (size_t index = row_begin * width; index < row_end * width; ++index)
+      layer.order[index] = visited[index] == visit_epoch ? expansion[index] : 0;    // 別次搜尋留下來的不算
   };
+  if (controller_ptr)
+    controller_ptr->threadPool().parallelFor(0, height, 64, gather);
+  else
+    gather(0, height);
+  return layer;
+}
+
+bool MazeModel::hasExpansionLayer() const
+{
+  return expansion_valid;
+}
+
+void MazeModel::setSeed(const std::optional<uint32_t> seed)
+{
+  fixed_seed = seed;
+}
+
+uint32_t MazeModel::lastSeed() const
+{
+  return last_seed;
+}
+
+MazeAction MazeModel::lastGenerator() const
+{
+  return last_generator;
+}
+
+/**
+ * @brief run one generator or solver, the same dispatch the controller and the benchmark use
+ */
+MazeStats MazeModel::runAction(const MazeAction action)
+{
+  MazeStats stats;
+  switch (action) {
+  case MazeAction::G_RESET: resetMaze(); break;
+  case MazeAction::G_PRIMS: stats = generateMazePrim(); break;
+  case MazeAction::G_RECURSION_BACKTRACKER: stats = generateMazeRecursionBacktracker(); break;
+  case MazeAction::G_RECURSION_DIVISION: stats = generateMazeRecursionDivision(); break;
+  case MazeAction::G_GROWING_TREE_NEWEST: stats = generateMazeGrowingTree<GrowingTreeNewest>(); break;
+  case MazeAction::G_GROWING_TREE_RANDOM: stats = generateMazeGrowingTree<GrowingTreeRandom>(); break;
+  case MazeAction::G_GROWING_TREE_OLDEST: stats = generateMazeGrowingTree<GrowingTreeOldest>(); break;
+  case MazeAction::G_GROWING_TREE_MIXED: stats = generateMazeGrowingTree<GrowingTreeMix<GrowingTreeNewest, GrowingTreeRandom, 75>>(); break;
+  case MazeAction::S_DFS: stats = solveMazeDFS(); break;
+  case MazeAction::S_BFS: stats = solveMazeBFS(); break;
+  case MazeAction::S_UCS_MANHATTAN:
+  case MazeAction::S_UCS_TWO_NORM:
+  case MazeAction::S_UCS_INTERVAL: stats = solveMazeUCS(action); break;
+  case MazeAction::S_GREEDY: stats = solveMazeGreedy(); break;
+  case MazeAction::S_ASTAR:
+  case MazeAction::S_ASTAR_INTERVAL: stats = solveMazeAStar(action); break;
+  }
+  if (action != MazeAction::G_RESET && action < MazeAction::S_DFS)
+    last_generator = action;
+  if (action < MazeAction::S_DFS)
+    expansion_valid = false;    // 格子變了，上一次搜尋的展開順序不能用了
+
+  flushDiffs();    // 最後不滿一批的也要送出去
+  return stats;
+}
+
+/* -------------------- private utility function --------------------   */
 
-  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> result;    // 待走的結點，greater代表小的會在前面，由小排到大
-  constexpr int32_t interval_y = MAZE_HEIGHT / 10, interval_x = MAZE_WIDTH / 10;    // 分 10 個區間
-  int32_t cost{}, weight{};
+/**
+ * @brief random generator for one generation run, seeded with the fixed seed if there is one
+ */
+std::mt19937 MazeModel::makeGenerator()
+{
+  last_seed = fixed_seed.value_or(static_cast<uint32_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+  return std::mt19937(last_seed);
+}
+
+/**
+ * @brief append one cell change to the pending batch, (-1, -1) only clears the highlighted node on the view
+ */
+void MazeModel::emitNode(const MazeNode &node)
+{
+  if (!controller_ptr)
+    return;
 
-  if (actions == MazeAction::S_ASTAR_INTERVAL) {
-    cost = 50;
-    weight = cost + abs(END_X - BEGIN_X) + abs(END_Y - BEGIN_Y);
+  const uint32_t index = node.y < 0 ? MazeDiffBatch::NO_CELL : static_cast<uint32_t>(cellIndex(node.y, node.x));
+  if (!pending_diffs.pushCell(index, node.element)) {
+    flushDiffs();
+    pending_diffs.pushCell(index, node.element);
   }
-  else if (actions == MazeAction::S_ASTAR_INTERVAL) {
-    cost = (static_cast<int32_t>(BEGIN_Y / interval_y) < static_cast<int32_t>(BEGIN_X / interval_x)) ? (10 - static_cast<int32_t>(BEGIN_Y / interval_y)) * 8 : (10 - static_cast<int32_t>(BEGIN_X / interval_x)) * 8;    // Cost 以區間計算，兩個相除是看它在第幾個區間，然後用總區間數減掉，代表它的基礎 Cost，再乘以8
-    weight = cost + pow_two_norm(BEGIN_Y, BEGIN_X);    // 權重以區間(Cost) + Two_Norm 計算
+}
+
+/**
+ * @brief append a run of length cells of one row starting at (y, x), all set to element
+ */
+void MazeModel::emitSpan(const int32_t y, const int32_t x, const int32_t length, const MazeElement element)
+{
+  if (!controller_ptr || length <= 0)
+    return;
+
+  const uint32_t begin = static_cast<uint32_t>(cellIndex(y, x));
+  if (!pending_diffs.pushSpan(begin, static_cast<uint32_t>(length), element)) {
+    flushDiffs();
+    pending_diffs.pushSpan(begin, static_cast<uint32_t>(length), element);
   }
-  result.push(Node(cost, weight, BEGIN_Y, BEGIN_X));    // 將起點加進去
+}
 
-  while (true) {
-    if (result.empty())
-      return;    // 沒找到目標
-    const auto temp = result.top();    // 目前最優先的結點
-    result.pop();    // 取出結點
+// 一次把整批交給畫面，producer 和 consumer 每一批只同步一次
+void MazeModel::flushDiffs()
+{
+  if (controller_ptr && !pending_diffs.empty()) {
+    controller_ptr->enFramequeue(pending_diffs);
+    pending_diffs.clear();
+  }
+}
 
-    if (temp.y == END_Y && temp.x == END_X) {
-      maze[temp.y][temp.x] = MazeElement::END;    // 終點
+void MazeModel::notifyComplete()
+{
+  flushDiffs();
+  if (controller_ptr)
+    controller_ptr->setModelComplete();
+}
 
-      return;    // 如果取出的點是終點就return
-    }
-    else if (maze[temp.y][temp.x] == MazeElement::GROUND) {
-      if (temp.y == BEGIN_Y && temp.x == BEGIN_X)
-        maze[temp.y][temp.x] = MazeElement::BEGIN;    // 起點
-      else {
-        maze[temp.y][temp.x] = MazeElement::EXPLORED;    // 探索過的點要改EXPLORED
-      }
+bool MazeModel::isCancelled() const
+{
+  return cancel_token && cancel_token->load(std::memory_order_relaxed);
+}
 
-      for (const auto &dir : dir_vec) {
-        const int32_t y = temp.y + dir.first, x = temp.x + dir.second;
+void MazeModel::startCheckpoint()
+{
+  checkpoint_tick = 0;
+  next_checkpoint = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(checkpoint_seconds));
+}
 
-        if (is_in_maze(y, x)) {
-          if (maze[y][x] == MazeElement::GROUND) {    // 如果這個結點還沒走過，就把他加到待走的結點裡
-            if (actions == MazeAction::S_ASTAR_INTERVAL) {
-              cost = 50;    // cost function設為常數 50
-              weight = cost + abs(END_X - x) + abs(END_Y - y);    // heuristic function 設為曼哈頓距離
-            }
-            else if (actions == MazeAction::S_ASTAR_INTERVAL) {
-              cost = (static_cast<int32_t>(y / interval_y) < static_cast<int32_t>(x / interval_x)) ? temp.__Cost + (10 - static_cast<int32_t>(y / interval_y)) * 8 : temp.__Cost + (10 - static_cast<int32_t>(x / interval_x)) * 8;    // Cost 以區間計算，兩個相除是看它在第幾個區間，然後用總區間數減掉，代表它的基礎 Cost，再乘以8
-              weight = cost + pow_two_norm(y, x);    // heuristic function 設為 two_norm 平方
-            }
-            result.push(Node(cost, weight, y, x));
-          }
-        }
-      }
-    }
-  }    // end while
-}    // end solveMazeAStar()
+/**
+ * @brief true once the checkpoint interval has passed, the clock is only read every CHECKPOINT_POLL calls
+ */
+bool MazeModel::checkpointDue()
+{
+  if (checkpoint_path.empty() || ++checkpoint_tick % CHECKPOINT_POLL != 0)
+    return false;
+  return std::chrono::steady_clock::now() >= next_checkpoint;
+}
 
-/* -------------------- private utility function --------------------   */
+/**
+ * @brief save state with the grid as it is now, resumed_ms is the time of the runs before this one
+ */
+void MazeModel::writeCheckpoint(MazeGeneratorState &state, const MazeStats &stats, const double resumed_ms)
+{
+  MAZE_TRACE_SCOPE("writeCheckpoint");
+  MazeStats so_far = stats;
+  so_far.stop();
+  so_far.elapsed_ms += resumed_ms;
+  if (!MazeCheckpoint::save(checkpoint_path, state, so_far, maze, begin_y, begin_x, end_y, end_x))
+    std::clog << "failed to write checkpoint " << checkpoint_path << std::endl;
+  startCheckpoint();
+}
+
+/**
+ * @brief a cancelled run keeps its place in a last checkpoint, a finished one has nothing left to resume
+ */
+void MazeModel::finishCheckpoint(MazeGeneratorState &state, const MazeStats &stats, const double resumed_ms)
+{
+  if (checkpoint_path.empty())
+    return;
+  if (isCancelled())
+    writeCheckpoint(state, stats, resumed_ms);
+  else
+    std::remove(checkpoint_path.c_str());
+}
 
 void MazeModel::setFlag()
 {
-  maze[BEGIN_Y][BEGIN_X] = MazeElement::BEGIN;
-  maze[END_Y][END_X] = MazeElement::END;
-  controller_ptr->enFramequeue(MazeNode{ BEGIN_Y, BEGIN_X, MazeElement::BEGIN });
-  controller_ptr->enFramequeue(MazeNode{ END_Y, END_X, MazeElement::END });
-  controller_ptr->enFramequeue(MazeNode{ -1, -1, MazeElement::INVALID });
+  maze[begin_y][begin_x] = MazeElement::BEGIN;
+  maze[end_y][end_x] = MazeElement::END;
+  emitNode(MazeNode{ begin_y, begin_x, MazeElement::BEGIN });
+  emitNode(MazeNode{ end_y, end_x, MazeElement::END });
+  emitNode(MazeNode{ -1, -1, MazeElement::INVALID });
 }
 
 bool MazeModel::inMaze(const MazeNode &node, const int32_t delta_y, const int32_t delta_x)
 {
-  return (node.y + delta_y < MAZE_HEIGHT - 1) && (node.x + delta_x < MAZE_WIDTH - 1) && (node.y + delta_y > 0) && (node.x + delta_x > 0);    // 下牆、右牆、上牆、左牆
+  return (node.y + delta_y < height - 1) && (node.x + delta_x < width - 1) && (node.y + delta_y > 0) && (node.x + delta_x > 0);    // 下牆、右牆、上牆、左牆
 }
 
 /**
  * @brief generate a random begin point for maze generation algorithm
  *
- * @param seed_y
- * @param seed_x
+ * @param node the chosen point
+ * @param gen the random generator of the running algorithm
  */
-void MazeModel::setBeginPoint(MazeNode &node)
+void MazeModel::setBeginPoint(MazeNode &node, std::mt19937 &gen)
 {
-  std::mt19937 gen(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-  std::uniform_int_distribution<> y_dis(0, (MAZE_HEIGHT - 3) / 2);
-  std::uniform_int_distribution<> x_dis(0, (MAZE_WIDTH - 3) / 2);
+  std::uniform_int_distribution<> y_dis(0, (height - 3) / 2);
+  std::uniform_int_distribution<> x_dis(0, (width - 3) / 2);
 
   node.y = 2 * y_dis(gen) + 1;
   node.x = 2 * x_dis(gen) + 1;
   node.element = MazeElement::EXPLORED;
   maze[node.y][node.x] = MazeElement::EXPLORED;    // Set the randomly chosen point as the generation start point
 
-  controller_ptr->enFramequeue(node);
+  emitNode(node);
 }    // end setBeginPoint
 
+/**
+ * @brief restore the cells carved by a generator from EXPLORED back to GROUND
+ *
+ * @param explored_cache the cells marked EXPLORED during generation
+ */
+void MazeModel::restoreExplored(const std::vector<MazeNode> &explored_cache)
+{
+  MAZE_TRACE_SCOPE("restoreExplored");
+  for (const MazeNode &node : explored_cache) {
+    maze[node.y][node.x] = MazeElement::GROUND;
+    emitNode(MazeNode{ node.y, node.x, MazeElement::GROUND });
+  }
+}
+
+/**
+ * @brief start a new search, every cell becomes unvisited without touching the visited array
+ *
+ * The array is only cleared when the 32-bit epoch wraps around.
+ */
+void MazeModel::nextVisitEpoch()
+{
+  if (visited.size() != maze.size()) {    // 讀進來的迷宮大小不一樣，第一次搜尋的時候才配置
+    visited.assign(maze.size(), 0);
+    parent.assign(maze.size(), 0);
+    open_list.resize(maze.size());
+    visit_epoch = 0;
+  }
+  if (track_expansion && expansion.size() != maze.size())
+    expansion.assign(maze.size(), 0);
+  else if (!track_expansion)
+    std::vector<uint32_t>().swap(expansion);    // 關掉之後不佔記憶體
+  expansion_count = 0;
+  expansion_valid = track_expansion;
+  if (++visit_epoch == 0) {
+    std::fill(visited.begin(), visited.end(), 0);
+    visit_epoch = 1;
+  }
+}
+
+size_t MazeModel::cellIndex(const int32_t y, const int32_t x) const
+{
+  return static_cast<size_t>(y) * width + x;
+}
+
+bool MazeModel::isVisited(const int32_t y, const int32_t x) const
+{
+  return visited[cellIndex(y, x)] == visit_epoch;
+}
+
+void MazeModel::setVisited(const int32_t y, const int32_t x, const size_t from)
+{
+  const size_t index = cellIndex(y, x);
+  visited[index] = visit_epoch;
+  parent[index] = static_cast<uint32_t>(from);
+  if (track_expansion)
+    expansion[index] = 0;
+
+  if (controller_ptr && maze[y][x] == MazeElement::GROUND)    // 起點和終點的顏色不蓋掉
+    emitOverlay(y, x, MazeElement::EXPLORED);
+}
+
+void MazeModel::markExpanded(const int32_t y, const int32_t x)
+{
+  if (track_expansion)
+    expansion[cellIndex(y, x)] = ++expansion_count;
+}
+
+/**
+ * @brief count the steps from the begin point to (y, x) by following the parent links of the current search
+ */
+uint64_t MazeModel::tracePath(const int32_t y, const int32_t x) const
+{
+  uint64_t length = 0;
+  for (size_t index = cellIndex(y, x); index != cellIndex(begin_y, begin_x) && length < parent.size(); index = parent[index])
+    ++length;
+
+  return length;
+}
+
+/**
+ * @brief stream the path ending at (y, x) to the view, from the begin point towards (y, x)
+ */
+void MazeModel::emitPath(const int32_t y, const int32_t x)
+{
+  if (!controller_ptr)
+    return;
+
+  std::vector<uint32_t> path;
+  for (size_t index = cellIndex(y, x); index != cellIndex(begin_y, begin_x) && path.size() < parent.size(); index = parent[index])
+    path.push_back(static_cast<uint32_t>(index));
+
+  for (auto it = path.rbegin(); it != path.rend(); ++it) {
+    const int32_t path_y = static_cast<int32_t>(*it / width), path_x = static_cast<int32_t>(*it % width);
+    if (maze[path_y][path_x] == MazeElement::GROUND)
+      emitOverlay(path_y, path_x, MazeElement::PATH);
+  }
+  emitNode(MazeNode{ -1, -1, MazeElement::INVALID });
+  flushDiffs();
+}
+
+/**
+ * @brief show a solver-only state of a cell on the view and remember it, so the next run can restore it
+ */
+void MazeModel::emitOverlay(const int32_t y, const int32_t x, const MazeElement element)
+{
+  solve_overlay.emplace_back(static_cast<uint32_t>(cellIndex(y, x)), element);
+  emitNode(MazeNode{ y, x, element });
+}
+
+/**
+ * @brief send the model state of every cell the last solver painted, EXPLORED and PATH never stay on screen across runs
+ */
+void MazeModel::clearOverlay()
+{
+  for (const auto &cell : solve_overlay) {
+    const int32_t y = static_cast<int32_t>(cell.first / width), x = static_cast<int32_t>(cell.first % width);
+    emitNode(MazeNode{ y, x, maze[y][x] });
+  }
+  solve_overlay.clear();
+}
+
+/**
+ * @brief bytes used by the per-cell arrays every search works with
+ */
+uint64_t MazeModel::searchMemory() const
+{
+  return (visited.size() + parent.size() + expansion.size() + open_list.idCount()) * sizeof(uint32_t);
+}
+
+bool MazeModel::isPassable(const int32_t y, const int32_t x)
+{
+  return is_in_maze(y, x) && maze[y][x] != MazeElement::WALL;
+}
+
 bool MazeModel::is_in_maze(const int32_t y, const int32_t x)
 {
-  return (y < MAZE_HEIGHT) && (x < MAZE_WIDTH) && (y >= 0) && (x >= 0);
+  return (y < height) && (x < width) && (y >= 0) && (x >= 0);
 }
 
 int32_t MazeModel::pow_two_norm(const int32_t y, const int32_t x)
 {
-  return pow((END_Y - y), 2) + pow((END_X - x), 2);
+  return pow((end_y - y), 2) + pow((end_x - x), 2);
 }
@@ -0,0 +1,80 @@
+#include "MazeMovingAI.h"
+#include "MazeTrace.h"
+
+#include <fstream>
+#include <sstream>
+
+bool MazeMovingAI::isPassable(const char terrain)
+{
+  return terrain == '.' || terrain == 'G' || terrain == 'S';
+}
+
+/**
+ * @brief read a .map file into grid, grid is only replaced when the whole file is valid
+ */
+bool MazeMovingAI::loadMap(const std::string &path, MazeGrid &grid)
+{
+  MAZE_TRACE_SCOPE("MazeMovingAI::loadMap");
+  std::ifstream is(path);
+  if (!is)
+    return false;
+
+  int32_t height = 0, width = 0;
+  std::string key;
+  while (is >> key && key != "map") {
+    if (key == "height") is >> height;
+    else if (key == "width") is >> width;
+    else if (key == "type") is >> key;    // 只有 octile 一種
+    else return false;
+  }
+  if (key != "map" || height <= 0 || width <= 0)
+    return false;
+
+  MazeGrid loaded(height, width, MazeElement::WALL);
+  std::string line;
+  std::getline(is, line);    // "map" 那一行剩下的部分
+  for (int32_t y = 0; y < height; ++y) {
+    if (!std::getline(is, line))
+      return false;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (static_cast<int32_t>(line.size()) < width)
+      return false;
+
+    MazeElement *row = loaded[y];
+    for (int32_t x = 0; x < width; ++x)
+      if (isPassable(line[x]))
+        row[x] = MazeElement::GROUND;
+  }
+
+  grid = std::move(loaded);
+  return true;
+}
+
+/**
+ * @brief read every query of a .scen file, appended to scenarios in file order
+ */
+bool MazeMovingAI::loadScenarios(const std::string &path, std::vector<MazeScenario> &scenarios)
+{
+  MAZE_TRACE_SCOPE("MazeMovingAI::loadScenarios");
+  std::ifstream is(path);
+  if (!is)
+    return false;
+
+  std::string line;
+  if (!std::getline(is, line) || line.compare(0, 7, "version") != 0)
+    return false;
+
+  while (std::getline(is, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    std::istringstream ss(line);
+    MazeScenario scenario;
+    if (!(ss >> scenario.bucket >> scenario.map >> scenario.map_width >> scenario.map_height
+             >> scenario.start_x >> scenario.start_y >> scenario.goal_x >> scenario.goal_y >> scenario.optimal_length))
+      return false;
+    scenarios.push_back(std::move(scenario));
+  }
+  return true;
+}
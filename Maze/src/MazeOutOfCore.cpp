@@ -0,0 +1,344 @@
+#include "MazeOutOfCore.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+  constexpr std::pair<int32_t, int32_t> DIRS[4]{ { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };    // 和 MazeModel 的 dir_vec 一樣
+  constexpr uint8_t ORIGIN = 5;
+  constexpr uint32_t NO_SET = UINT32_MAX;
+}    // namespace
+
+MazeOutOfCore::MazeOutOfCore(MazeTiledGrid &grid, std::string scratch_path, const size_t scratch_resident_bytes)
+    : begin_y{ 1 }, begin_x{ 0 }, end_y{ std::max(grid.height() - 2, 0) }, end_x{ grid.width() - 1 },
+      grid{ grid }, scratch_path{ std::move(scratch_path) }, scratch_resident_bytes{ scratch_resident_bytes } {}
+
+void MazeOutOfCore::setEndpoints(const int32_t begin_y, const int32_t begin_x, const int32_t end_y, const int32_t end_x)
+{
+  this->begin_y = begin_y, this->begin_x = begin_x;
+  this->end_y = end_y, this->end_x = end_x;
+}
+
+/**
+ * @brief recursive backtracker without a stack, the way back is the direction byte of every carved cell
+ *
+ * The scratch file only has one byte per maze cell (odd coordinates), a quarter of the grid.
+ */
+MazeStats MazeOutOfCore::generateBacktracker(const uint32_t seed)
+{
+  MAZE_TRACE_SCOPE("MazeOutOfCore::generateBacktracker");
+  MazeStats stats;
+  stats.start();
+
+  const int32_t rows = (grid.height() - 1) / 2, cols = (grid.width() - 1) / 2;
+  if (rows <= 0 || cols <= 0 || !openScratch(rows, cols))
+    return stats;
+  fillWalls();
+
+  std::mt19937 gen(seed);
+  int32_t cy = std::uniform_int_distribution<int32_t>(0, rows - 1)(gen);
+  int32_t cx = std::uniform_int_distribution<int32_t>(0, cols - 1)(gen);
+  grid[2 * cy + 1][2 * cx + 1] = MazeElement::GROUND;
+  from[cy][cx] = ORIGIN;
+  ++stats.pushes;
+  ++stats.nodes_expanded;
+
+  while (true) {
+    int8_t candidates[4];
+    int32_t count = 0;
+    for (int8_t dir = 0; dir < 4; ++dir) {
+      const int32_t ny = cy + DIRS[dir].first, nx = cx + DIRS[dir].second;
+      if (ny >= 0 && ny < rows && nx >= 0 && nx < cols && grid[2 * ny + 1][2 * nx + 1] == MazeElement::WALL)    // 還沒挖過的格子
+        candidates[count++] = dir;
+    }
+
+    if (count) {
+      const int8_t dir = candidates[std::uniform_int_distribution<int32_t>(0, count - 1)(gen)];
+      grid[2 * cy + 1 + DIRS[dir].first][2 * cx + 1 + DIRS[dir].second] = MazeElement::GROUND;    // 中間的牆
+      cy += DIRS[dir].first, cx += DIRS[dir].second;
+      grid[2 * cy + 1][2 * cx + 1] = MazeElement::GROUND;
+      from[cy][cx] = static_cast<uint8_t>(dir + 1);
+      ++stats.pushes;
+      stats.nodes_expanded += 2;
+      continue;
+    }
+
+    const uint8_t back = from[cy][cx];
+    if (back == ORIGIN)
+      break;
+    cy -= DIRS[back - 1].first, cx -= DIRS[back - 1].second;    // 沒有路可以挖了，退回來的那一格
+    ++stats.pops;
+  }
+
+  closeScratch();
+  setFlag();
+  stats.trackOpen(0, 0, residentBytes());
+  stats.stop();
+  return stats;
+}
+
+/**
+ * @brief Eller's algorithm, one row of cells at a time with O(width) memory, every cell of the grid is written once
+ *
+ * Neighbouring cells of a row are joined at random unless they are in the same set already, then every set
+ * continues downward through at least one cell; the last row joins every set that is left.
+ */
+MazeStats MazeOutOfCore::generateEller(const uint32_t seed)
+{
+  MAZE_TRACE_SCOPE("MazeOutOfCore::generateEller");
+  MazeStats stats;
+  stats.start();
+
+  from.resetStats();    // 不需要 scratch 檔
+  const int32_t height = grid.height(), width = grid.width();
+  const int32_t rows = (height - 1) / 2, cols = (width - 1) / 2;
+  if (rows <= 0 || cols <= 0)
+    return stats;
+
+  std::mt19937 gen(seed);
+  std::bernoulli_distribution coin(0.5);
+  std::vector<uint32_t> set(cols, NO_SET);    // 目前這一列每一格所在的集合
+  std::vector<uint32_t> dsu(cols);    // 這一列裡面合併集合用
+  std::vector<uint32_t> seen(cols), chosen(cols);    // 每個集合有幾格、保底往下挖的那一格
+  std::vector<uint8_t> used(cols), carved(cols), right(cols), down(cols);
+  std::vector<uint32_t> free_ids;
+  const auto find = [&](uint32_t id) {
+    while (dsu[id] != id)
+      id = dsu[id] = dsu[dsu[id]];
+    return id;
+  };
+
+  for (int32_t x = 0; x < width; ++x)
+    grid[0][x] = MazeElement::WALL;
+
+  for (int32_t r = 0; r < rows; ++r) {
+    const bool last = r == rows - 1;
+
+    // 上一列沒有往下挖到的格子是新的集合
+    std::fill(used.begin(), used.end(), 0);
+    for (const uint32_t id : set)
+      if (id != NO_SET)
+        used[id] = 1;
+    free_ids.clear();
+    for (uint32_t id = 0; id < static_cast<uint32_t>(cols); ++id)
+      if (!used[id])
+        free_ids.push_back(id);
+    for (uint32_t &id : set)
+      if (id == NO_SET) {
+        id = free_ids.back();
+        free_ids.pop_back();
+      }
+    for (uint32_t id = 0; id < static_cast<uint32_t>(cols); ++id)
+      dsu[id] = id;
+
+    for (int32_t c = 0; c + 1 < cols; ++c) {
+      const uint32_t a = find(set[c]), b = find(set[c + 1]);
+      right[c] = a != b && (last || coin(gen));
+      if (right[c])
+        dsu[b] = a;
+    }
+    right[cols - 1] = 0;
+    for (uint32_t &id : set)
+      id = find(id);
+
+    std::fill(down.begin(), down.end(), 0);
+    if (!last) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::fill(carved.begin(), carved.end(), 0);
+      for (int32_t c = 0; c < cols; ++c) {
+        const uint32_t id = set[c];
+        if (std::uniform_int_distribution<uint32_t>(0, seen[id]++)(gen) == 0)    // reservoir sampling，每一格被選到的機率一樣
+          chosen[id] = static_cast<uint32_t>(c);
+        down[c] = coin(gen);
+        carved[id] |= down[c];
+      }
+      for (int32_t c = 0; c < cols; ++c)
+        if (seen[set[c]] && !carved[set[c]]) {
+          down[chosen[set[c]]] = 1;
+          carved[set[c]] = 1;
+        }
+    }
+
+    // 格子那一列和下面那一列整列寫出去
+    const int32_t y = 2 * r + 1;
+    for (int32_t x = 0; x < width; ++x) {
+      const int32_t c = (x - 1) / 2;
+      const bool in_cells = x >= 1 && c < cols;
+      grid[y][x] = in_cells && (x % 2 == 1 || right[c]) ? MazeElement::GROUND : MazeElement::WALL;
+    }
+    for (int32_t x = 0; x < width; ++x)
+      grid[y + 1][x] = x % 2 == 1 && (x - 1) / 2 < cols && down[(x - 1) / 2] ? MazeElement::GROUND : MazeElement::WALL;
+
+    for (int32_t c = 0; c < cols; ++c) {
+      stats.nodes_expanded += 1 + right[c] + down[c];
+      if (!down[c])
+        set[c] = NO_SET;
+    }
+  }
+
+  for (int32_t y = 2 * rows + 1; y < height; ++y)
+    for (int32_t x = 0; x < width; ++x)
+      grid[y][x] = MazeElement::WALL;
+
+  setFlag();
+  stats.trackOpen(0, 0, static_cast<uint64_t>(cols) * (6 * sizeof(uint32_t) + 4) + residentBytes());
+  stats.stop();
+  return stats;
+}
+
+MazeStats MazeOutOfCore::solveBFS()
+{
+  MAZE_TRACE_SCOPE("MazeOutOfCore::solveBFS");
+  MazeStats stats;
+  stats.start();
+  if (!openScratch(grid.height(), grid.width()))
+    return stats;
+
+  std::queue<std::pair<int32_t, int32_t>> result;
+  result.push(std::make_pair(begin_y, begin_x));
+  from[begin_y][begin_x] = ORIGIN;
+  ++stats.pushes;
+
+  while (!result.empty()) {
+    const auto [temp_y, temp_x]{ result.front() };
+    result.pop();
+    ++stats.pops;
+    ++stats.nodes_expanded;
+
+    for (uint8_t dir = 0; dir < 4; ++dir) {
+      const int32_t y = temp_y + DIRS[dir].first, x = temp_x + DIRS[dir].second;
+      if (!isPassable(y, x) || from[y][x])
+        continue;
+
+      from[y][x] = static_cast<uint8_t>(dir + 1);
+      if (y == end_y && x == end_x) {
+        stats.path_length = tracePath();
+        closeScratch();
+        stats.stop();
+        return stats;
+      }
+      result.push(std::make_pair(y, x));
+      ++stats.pushes;
+    }
+    stats.trackOpen(result.size(), sizeof(std::pair<int32_t, int32_t>), residentBytes());
+  }
+
+  closeScratch();
+  stats.stop();
+  return stats;
+}
+
+/**
+ * @brief A* with a Manhattan heuristic and unit steps, so the first time the end is popped its path is the shortest
+ *
+ * There is no per-cell cost array, a cell can be in the open list a few times and only its first pop counts.
+ */
+MazeStats MazeOutOfCore::solveAStar()
+{
+  struct OpenNode {
+    int64_t f, g;
+    int32_t y, x;
+    uint8_t dir;
+    bool operator>(const OpenNode &other) const { return f != other.f ? f > other.f : g < other.g; }    // 一樣的 f 先走比較深的
+  };
+
+  MAZE_TRACE_SCOPE("MazeOutOfCore::solveAStar");
+  MazeStats stats;
+  stats.start();
+  if (!openScratch(grid.height(), grid.width()))
+    return stats;
+
+  const auto heuristic = [&](const int32_t y, const int32_t x) -> int64_t { return std::abs(end_y - y) + std::abs(end_x - x); };
+  std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> open_list;
+  open_list.push(OpenNode{ heuristic(begin_y, begin_x), 0, begin_y, begin_x, ORIGIN });
+  ++stats.pushes;
+
+  while (!open_list.empty()) {
+    const OpenNode temp = open_list.top();
+    open_list.pop();
+    ++stats.pops;
+    if (from[temp.y][temp.x])
+      continue;    // 已經用更短的路走過了
+
+    from[temp.y][temp.x] = temp.dir;
+    if (temp.y == end_y && temp.x == end_x) {
+      stats.path_length = tracePath();
+      break;
+    }
+    ++stats.nodes_expanded;
+
+    for (uint8_t dir = 0; dir < 4; ++dir) {
+      const int32_t y = temp.y + DIRS[dir].first, x = temp.x + DIRS[dir].second;
+      if (isPassable(y, x) && !from[y][x]) {
+        open_list.push(OpenNode{ temp.g + 1 + heuristic(y, x), temp.g + 1, y, x, static_cast<uint8_t>(dir + 1) });
+        ++stats.pushes;
+      }
+    }
+    stats.trackOpen(open_list.size(), sizeof(OpenNode), residentBytes());
+  }
+
+  closeScratch();
+  stats.stop();
+  return stats;
+}
+
+bool MazeOutOfCore::openScratch(const int32_t height, const int32_t width)
+{
+  return from.create(scratch_path, height, width, scratch_resident_bytes);
+}
+
+void MazeOutOfCore::closeScratch()
+{
+  from.close();
+  std::remove(scratch_path.c_str());
+}
+
+/**
+ * @brief set every cell to a wall, tile by tile so every tile is faulted in once
+ */
+void MazeOutOfCore::fillWalls()
+{
+  const int32_t side = grid.tileSide();
+  for (int32_t ty = 0; ty < grid.height(); ty += side)
+    for (int32_t tx = 0; tx < grid.width(); tx += side)
+      for (int32_t y = ty; y < std::min(ty + side, grid.height()); ++y)
+        for (int32_t x = tx; x < std::min(tx + side, grid.width()); ++x)
+          grid[y][x] = MazeElement::WALL;
+}
+
+void MazeOutOfCore::setFlag()
+{
+  grid[begin_y][begin_x] = MazeElement::BEGIN;
+  grid[end_y][end_x] = MazeElement::END;
+}
+
+bool MazeOutOfCore::isPassable(const int32_t y, const int32_t x)
+{
+  return y >= 0 && y < grid.height() && x >= 0 && x < grid.width() && grid[y][x] != MazeElement::WALL;
+}
+
+/**
+ * @brief steps from the begin point to the end point, following the direction bytes back from the end
+ */
+uint64_t MazeOutOfCore::tracePath()
+{
+  uint64_t length = 0;
+  int32_t y = end_y, x = end_x;
+  for (uint8_t dir = from[y][x]; dir != ORIGIN; dir = from[y][x]) {
+    y -= DIRS[dir - 1].first, x -= DIRS[dir - 1].second;
+    ++length;
+  }
+  return length;
+}
+
+uint64_t MazeOutOfCore::residentBytes() const
+{
+  return grid.residentLimit() + (from.isOpen() ? from.residentLimit() : 0);
+}
@@ -0,0 +1,266 @@
+#include "MazeReplay.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  constexpr char HEADER_MAGIC[4]{ 'M', 'Z', 'R', 'P' };
+  constexpr char FOOTER_MAGIC[4]{ 'M', 'Z', 'R', 'E' };
+  constexpr uint32_t REPLAY_VERSION = 2;    // 2: 加了 Growing Tree 之後解法的編號往後移
+  constexpr uint64_t MIN_KEYFRAME_INTERVAL = 4096;
+
+  enum RecordType : uint8_t {
+    RECORD_KEYFRAME = 1,
+    RECORD_BATCH = 2,
+    RECORD_END = 3,
+  };
+
+  template <typename T>
+  void writePod(std::ostream &os, const T &value)
+  {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void writeArray(std::ostream &os, const T *values, const size_t count)
+  {
+    os.write(reinterpret_cast<const char *>(values), static_cast<std::streamsize>(sizeof(T) * count));
+  }
+
+  template <typename T>
+  bool readPod(std::istream &is, T &value)
+  {
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(&value), sizeof(T)));
+  }
+
+  template <typename T>
+  bool readArray(std::istream &is, T *values, const size_t count)
+  {
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(values), static_cast<std::streamsize>(sizeof(T) * count)));
+  }
+}    // namespace
+
+/* -------------------- writer -------------------- */
+
+/**
+ * @brief start a recording, the current grid becomes the keyframe at position 0
+ *
+ * Keyframes are written every max(height * width, 4096) diffs, so they never take much more room than the diffs
+ * between them, and a seek never has to apply more diffs than that.
+ */
+bool MazeReplayWriter::open(const std::string &path, const int32_t height, const int32_t width, const MazeAction action, const MazeGrid &maze)
+{
+  os.open(path, std::ios::binary | std::ios::trunc);
+  if (!os)
+    return false;
+
+  this->height = height;
+  this->width = width;
+  this->action = action;
+  keyframes.clear();
+  position = last_keyframe = 0;
+  keyframe_interval = std::max<uint64_t>(static_cast<uint64_t>(height) * width, MIN_KEYFRAME_INTERVAL);
+
+  os.write(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+  writePod(os, REPLAY_VERSION);
+  writePod(os, height);
+  writePod(os, width);
+
+  recordFrame(maze);
+  return static_cast<bool>(os);
+}
+
+// 整張圖被換掉了 (setFrameMaze)，直接寫一張 keyframe
+void MazeReplayWriter::recordFrame(const MazeGrid &maze)
+{
+  if (!isOpen())
+    return;
+
+  shadow.assign(maze.data(), maze.data() + maze.size());
+  writeKeyframe();
+}
+
+void MazeReplayWriter::recordBatch(const MazeDiffBatch &batch)
+{
+  if (!isOpen())
+    return;
+
+  writePod(os, RECORD_BATCH);
+  writePod(os, batch.cell_count);
+  writePod(os, batch.span_count);
+  writeArray(os, batch.cell_index, batch.cell_count);
+  writeArray(os, batch.cell_element, batch.cell_count);
+  writeArray(os, batch.span_begin, batch.span_count);
+  writeArray(os, batch.span_length, batch.span_count);
+  writeArray(os, batch.span_element, batch.span_count);
+
+  for (uint32_t i = 0; i < batch.span_count; ++i)
+    std::fill_n(shadow.begin() + batch.span_begin[i], batch.span_length[i], batch.span_element[i]);
+  for (uint32_t i = 0; i < batch.cell_count; ++i)
+    if (batch.cell_index[i] != MazeDiffBatch::NO_CELL)
+      shadow[batch.cell_index[i]] = batch.cell_element[i];
+
+  // keyframe 只放在 batch 的邊界，seek 的時候最多只要套用一個 interval 加一個 batch
+  position += batch.cell_count + batch.span_count;
+  if (position - last_keyframe >= keyframe_interval)
+    writeKeyframe();
+}
+
+void MazeReplayWriter::writeKeyframe()
+{
+  MAZE_TRACE_SCOPE("writeKeyframe");
+  keyframes.push_back(Keyframe{ position, static_cast<uint64_t>(os.tellp()) });
+  last_keyframe = position;
+
+  writePod(os, RECORD_KEYFRAME);
+  writePod(os, position);
+  writeArray(os, shadow.data(), shadow.size());
+}
+
+/**
+ * @brief write the footer with the keyframe index and close the file
+ *
+ * @param seed the seed of the maze the run worked on, only known once the run is over
+ */
+bool MazeReplayWriter::close(const uint32_t seed)
+{
+  if (!isOpen())
+    return false;
+
+  writePod(os, RECORD_END);
+  const uint64_t footer_offset = static_cast<uint64_t>(os.tellp());
+  writePod(os, seed);
+  writePod(os, static_cast<int32_t>(action));
+  writePod(os, position);
+  writePod(os, static_cast<uint64_t>(keyframes.size()));
+  for (const Keyframe &keyframe : keyframes) {
+    writePod(os, keyframe.position);
+    writePod(os, keyframe.offset);
+  }
+  writePod(os, footer_offset);
+  os.write(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+
+  const bool ok = static_cast<bool>(os);
+  os.close();
+  shadow.clear();
+  shadow.shrink_to_fit();
+  return ok;
+}
+
+/* -------------------- reader -------------------- */
+
+bool MazeReplayReader::open(const std::string &path)
+{
+  is.close();
+  is.clear();
+  is.open(path, std::ios::binary);
+  if (!is)
+    return false;
+
+  char magic[4];
+  uint32_t version = 0;
+  if (!readArray(is, magic, sizeof(magic)) || std::memcmp(magic, HEADER_MAGIC, sizeof(magic)) != 0 || !readPod(is, version) || version != REPLAY_VERSION || !readPod(is, grid_height) || !readPod(is, grid_width) || grid_height <= 0 || grid_width <= 0) {
+    is.close();
+    return false;
+  }
+
+  // footer 的位置寫在檔案最後面
+  uint64_t footer_offset = 0;
+  is.seekg(0, std::ios::end);
+  const uint64_t file_size = static_cast<uint64_t>(is.tellg());
+  is.seekg(-static_cast<std::streamoff>(sizeof(uint64_t) + sizeof(FOOTER_MAGIC)), std::ios::end);
+  if (!readPod(is, footer_offset) || !readArray(is, magic, sizeof(magic)) || std::memcmp(magic, FOOTER_MAGIC, sizeof(magic)) != 0 || footer_offset > file_size
+      || static_cast<uint64_t>(grid_height) * grid_width > file_size) {    // 至少要放得下一張 keyframe
+    is.close();    // 沒有 footer 代表錄到一半就結束了
+    return false;
+  }
+
+  int32_t action = 0;
+  uint64_t keyframe_count = 0;
+  is.seekg(static_cast<std::streamoff>(footer_offset));
+  if (!readPod(is, run_seed) || !readPod(is, action) || !readPod(is, diff_count) || !readPod(is, keyframe_count) || action < 0 || action >= MAZE_ACTION_COUNT) {
+    is.close();
+    return false;
+  }
+  run_action = static_cast<MazeAction>(action);
+
+  if (keyframe_count > (file_size - footer_offset) / sizeof(Keyframe)) {    // 每張 keyframe 在 footer 裡佔 16 byte，壞掉的數量不能拿去配置
+    is.close();
+    return false;
+  }
+  keyframes.resize(keyframe_count);
+  for (Keyframe &keyframe : keyframes) {
+    if (!readPod(is, keyframe.position) || !readPod(is, keyframe.offset)) {
+      is.close();
+      return false;
+    }
+  }
+
+  return !keyframes.empty();
+}
+
+/**
+ * @brief rebuild the grid as it was after the first target diffs: load the last keyframe at or before target, then apply the diffs after it
+ */
+bool MazeReplayReader::seek(const uint64_t target, MazeGrid &maze)
+{
+  MAZE_TRACE_SCOPE("MazeReplayReader::seek");
+  if (!isOpen())
+    return false;
+
+  // 同一個位置可能有好幾張 keyframe (例如 setFrameMaze 之後剛好到週期)，要拿最後一張
+  const auto it = std::upper_bound(keyframes.begin(), keyframes.end(), target, [](const uint64_t pos, const Keyframe &keyframe) { return pos < keyframe.position; });
+  const Keyframe &keyframe = it == keyframes.begin() ? keyframes.front() : *std::prev(it);
+
+  is.clear();
+  is.seekg(static_cast<std::streamoff>(keyframe.offset));
+  uint8_t type = 0;
+  uint64_t position = 0;
+  if (!readPod(is, type) || type != RECORD_KEYFRAME || !readPod(is, position))
+    return false;
+
+  if (maze.height() != grid_height || maze.width() != grid_width)
+    maze = MazeGrid(grid_height, grid_width);
+  if (!readArray(is, maze.data(), maze.size()))
+    return false;
+
+  while (position < target) {
+    if (!readPod(is, type))
+      return false;
+    if (type == RECORD_END)
+      break;
+    if (type == RECORD_KEYFRAME) {    // 整張圖被換掉了
+      if (!readPod(is, position))
+        return false;
+      if (!readArray(is, maze.data(), maze.size()))
+        return false;
+      continue;
+    }
+
+    if (!readPod(is, batch.cell_count) || !readPod(is, batch.span_count) || batch.cell_count > MazeDiffBatch::CELL_CAPACITY || batch.span_count > MazeDiffBatch::SPAN_CAPACITY)
+      return false;
+    if (!readArray(is, batch.cell_index, batch.cell_count) || !readArray(is, batch.cell_element, batch.cell_count) || !readArray(is, batch.span_begin, batch.span_count) || !readArray(is, batch.span_length, batch.span_count) || !readArray(is, batch.span_element, batch.span_count))
+      return false;
+
+    // 索引是從檔案讀的，超出格子的整批都不要
+    const uint64_t cells = maze.size();
+    for (uint32_t i = 0; i < batch.span_count; ++i)
+      if (batch.span_begin[i] > cells || batch.span_length[i] > cells - batch.span_begin[i])
+        return false;
+    for (uint32_t i = 0; i < batch.cell_count; ++i)
+      if (batch.cell_index[i] != MazeDiffBatch::NO_CELL && batch.cell_index[i] >= cells)
+        return false;
+
+    // 和畫面一樣先套用 span 再套用 cell，目標在這一批中間的話只套用前面一部分
+    for (uint32_t i = 0; i < batch.span_count && position < target; ++i, ++position) {
+      const int32_t y = batch.span_begin[i] / grid_width, x = batch.span_begin[i] % grid_width;
+      std::fill_n(maze[y] + x, batch.span_length[i], batch.span_element[i]);
+    }
+    for (uint32_t i = 0; i < batch.cell_count && position < target; ++i, ++position)
+      if (batch.cell_index[i] != MazeDiffBatch::NO_CELL)
+        maze[batch.cell_index[i] / grid_width][batch.cell_index[i] % grid_width] = batch.cell_element[i];
+  }
+
+  return true;
+}
@@ -0,0 +1,343 @@
+#include "MazeSharedGrid.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MazeSharedHeader) <= MazeSharedGrid::HEADER_BYTES, "MazeSharedHeader must fit in HEADER_BYTES");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int32_t>::is_always_lock_free, "the seqlock needs address-free atomics to work across processes");
+
+namespace {
+  constexpr char SHARED_MAGIC[4]{ 'M', 'Z', 'S', 'H' };
+}    // namespace
+
+MazeSharedGrid::~MazeSharedGrid()
+{
+  close();
+}
+
+/**
+ * @brief create (or take over) the segment name and size it for a height x width grid, as the writer
+ */
+bool MazeSharedGrid::create(const std::string &name, const int32_t height, const int32_t width)
+{
+  close();
+  if (height < 0 || width < 0)
+    return false;
+#if defined(_WIN32)
+  (void) name;
+  return false;    // 沒有 POSIX shared memory
+#else
+  fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0)
+    return false;
+  this->name = name;
+  writer = true;
+
+  const size_t cell_bytes = std::max<size_t>(static_cast<size_t>(height) * width, 1);
+  if (::ftruncate(fd, static_cast<off_t>(HEADER_BYTES + cell_bytes)) != 0 || !map(HEADER_BYTES + cell_bytes)) {
+    close();
+    return false;
+  }
+
+  // 先把 sequence 設成奇數，讀的人在 header 寫完之前不會拿到任何東西
+  header->sequence.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+  header->layout = LAYOUT;
+  header->version.store(0, std::memory_order_relaxed);
+  header->capacity.store(cell_bytes, std::memory_order_relaxed);
+  header->height.store(height, std::memory_order_relaxed);
+  header->width.store(width, std::memory_order_relaxed);
+  std::memset(cells, static_cast<int>(MazeElement::WALL), cell_bytes);
+  header->sequence.store(2, std::memory_order_release);
+  return true;
+#endif
+}
+
+/**
+ * @brief map an existing segment read-only, as a reader
+ */
+bool MazeSharedGrid::open(const std::string &name)
+{
+  close();
+#if defined(_WIN32)
+  (void) name;
+  return false;
+#else
+  fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  this->name = name;
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_BYTES || !map(static_cast<size_t>(info.st_size))
+      || std::memcmp(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) != 0 || header->layout != LAYOUT) {
+    close();
+    return false;
+  }
+  return true;
+#endif
+}
+
+/**
+ * @brief unmap, the writer also removes the name so no reader can open a segment nobody updates
+ */
+void MazeSharedGrid::close()
+{
+  unmap();
+#if !defined(_WIN32)
+  if (fd >= 0)
+    ::close(fd);
+  if (writer && !name.empty())
+    ::shm_unlink(name.c_str());
+#endif
+  fd = -1;
+  writer = false;
+  name.clear();
+}
+
+/**
+ * @brief publish the whole grid, the segment grows first if the grid does not fit
+ */
+bool MazeSharedGrid::publish(const MazeGrid &grid)
+{
+  MAZE_TRACE_SCOPE("MazeSharedGrid::publish");
+  if (!writer || !reserve(grid.size()))
+    return false;
+
+  beginWrite();
+  header->height.store(grid.height(), std::memory_order_relaxed);
+  header->width.store(grid.width(), std::memory_order_relaxed);
+  std::memcpy(cells, grid.data(), grid.size());
+  endWrite();
+  return true;
+}
+
+/**
+ * @brief publish rows [y0, y1) of a grid with the shape already published
+ */
+bool MazeSharedGrid::publishRows(const MazeGrid &grid, const int32_t y0, const int32_t y1)
+{
+  MAZE_TRACE_SCOPE("MazeSharedGrid::publishRows");
+  if (!writer || grid.height() != header->height.load(std::memory_order_relaxed) || grid.width() != header->width.load(std::memory_order_relaxed))
+    return false;
+  if (y0 >= y1)
+    return true;
+
+  const size_t offset = static_cast<size_t>(y0) * grid.width();
+  beginWrite();
+  std::memcpy(cells + offset, grid.data() + offset, static_cast<size_t>(y1 - y0) * grid.width());
+  endWrite();
+  return true;
+}
+
+/**
+ * @brief copy a consistent grid and the version it belongs to, false if every attempt overlapped a write
+ *
+ * A reader whose mapping is older than a grown segment maps it again and retries.
+ */
+bool MazeSharedGrid::snapshot(MazeGrid &grid, uint64_t &version, const uint32_t max_attempts)
+{
+  MAZE_TRACE_SCOPE("MazeSharedGrid::snapshot");
+  if (!isOpen())
+    return false;
+
+  for (uint32_t attempt = 0; attempt < max_attempts; ++attempt) {
+    const uint64_t begin = header->sequence.load(std::memory_order_acquire);
+    if (begin & 1) {
+      ++retry_count;
+      std::this_thread::yield();
+      continue;
+    }
+
+    const int32_t height = header->height.load(std::memory_order_relaxed);
+    const int32_t width = header->width.load(std::memory_order_relaxed);
+    const uint64_t capacity = header->capacity.load(std::memory_order_relaxed);
+    const uint64_t current = header->version.load(std::memory_order_relaxed);
+    const size_t cell_count = static_cast<size_t>(std::max(height, 0)) * std::max(width, 0);
+    if (HEADER_BYTES + capacity > mapped_bytes) {    // writer 把 segment 變大了
+#if !defined(_WIN32)
+      struct stat info;
+      if (::fstat(fd, &info) != 0 || !map(static_cast<size_t>(info.st_size)))
+        return false;
+#endif
+      continue;
+    }
+    if (cell_count > capacity) {    // 讀到寫到一半的大小
+      ++retry_count;
+      continue;
+    }
+
+    if (grid.height() != height || grid.width() != width)
+      grid = MazeGrid(height, width);
+    std::memcpy(grid.data(), cells, cell_count);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->sequence.load(std::memory_order_relaxed) == begin) {
+      version = current;
+      return true;
+    }
+    ++retry_count;
+  }
+  return false;
+}
+
+/**
+ * @brief the version of the last complete publish, cheap enough to poll before deciding to take a snapshot
+ */
+uint64_t MazeSharedGrid::version() const
+{
+  return header ? header->version.load(std::memory_order_acquire) : 0;
+}
+
+bool MazeSharedGrid::map(const size_t bytes)
+{
+  unmap();
+#if defined(_WIN32)
+  (void) bytes;
+  return false;
+#else
+  void *base = ::mmap(nullptr, bytes, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+    return false;
+  header = static_cast<MazeSharedHeader *>(base);
+  cells = static_cast<uint8_t *>(base) + HEADER_BYTES;
+  mapped_bytes = bytes;
+  return true;
+#endif
+}
+
+void MazeSharedGrid::unmap()
+{
+#if !defined(_WIN32)
+  if (header)
+    ::munmap(header, mapped_bytes);
+#endif
+  header = nullptr;
+  cells = nullptr;
+  mapped_bytes = 0;
+}
+
+/**
+ * @brief make the cells area hold at least cell_bytes, the segment only ever grows
+ */
+bool MazeSharedGrid::reserve(const size_t cell_bytes)
+{
+  const uint64_t capacity = header->capacity.load(std::memory_order_relaxed);
+  if (cell_bytes <= capacity)
+    return true;
+#if defined(_WIN32)
+  return false;
+#else
+  const size_t bytes = HEADER_BYTES + std::max<size_t>(cell_bytes, capacity + capacity / 2);    // 一次多長一點，連續變大的時候不用每次都重新映射
+  if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0 || !map(bytes))
+    return false;
+  header->capacity.store(bytes - HEADER_BYTES, std::memory_order_relaxed);
+  return true;
+#endif
+}
+
+void MazeSharedGrid::beginWrite()
+{
+  header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void MazeSharedGrid::endWrite()
+{
+  header->version.store(header->version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/* -------------------- MazeSharedPublisher -------------------- */
+
+/**
+ * @brief create the segment and publish maze, later changes are published at most every interval_ms
+ */
+bool MazeSharedPublisher::open(const std::string &name, const MazeGrid &maze, const double interval_ms)
+{
+  if (!shared.create(name, maze.height(), maze.width()))
+    return false;
+  interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(std::max(interval_ms, 0.0)));
+  recordFrame(maze);
+  flush();
+  return true;
+}
+
+void MazeSharedPublisher::close()
+{
+  shared.close();
+  shadow = MazeGrid();
+  dirty_y0 = dirty_y1 = 0;
+  reshaped = false;
+}
+
+void MazeSharedPublisher::recordFrame(const MazeGrid &maze)
+{
+  if (!isOpen())
+    return;
+  reshaped = reshaped || !maze.sameShape(shadow);
+  shadow = maze;
+  markRows(0, shadow.height());
+  maybeFlush();
+}
+
+void MazeSharedPublisher::recordBatch(const MazeDiffBatch &batch)
+{
+  if (!isOpen() || shadow.empty())
+    return;
+
+  const uint32_t width = static_cast<uint32_t>(shadow.width());
+  for (uint32_t i = 0; i < batch.span_count; ++i) {
+    std::fill_n(shadow.data() + batch.span_begin[i], batch.span_length[i], batch.span_element[i]);
+    const int32_t y = static_cast<int32_t>(batch.span_begin[i] / width);
+    markRows(y, y + 1);
+  }
+  for (uint32_t i = 0; i < batch.cell_count; ++i) {
+    if (batch.cell_index[i] == MazeDiffBatch::NO_CELL)
+      continue;
+    shadow.data()[batch.cell_index[i]] = batch.cell_element[i];
+    const int32_t y = static_cast<int32_t>(batch.cell_index[i] / width);
+    markRows(y, y + 1);
+  }
+  maybeFlush();
+}
+
+/**
+ * @brief publish whatever changed since the last publish now, the end of every job calls this
+ */
+void MazeSharedPublisher::flush()
+{
+  if (!isOpen() || (dirty_y0 >= dirty_y1 && !reshaped))
+    return;
+
+  const bool published = reshaped ? shared.publish(shadow) : shared.publishRows(shadow, dirty_y0, dirty_y1);
+  if (published) {
+    reshaped = false;
+    dirty_y0 = dirty_y1 = 0;
+  }
+  last_publish = std::chrono::steady_clock::now();
+}
+
+void MazeSharedPublisher::markRows(const int32_t y0, const int32_t y1)
+{
+  if (dirty_y0 >= dirty_y1)
+    dirty_y0 = y0, dirty_y1 = y1;
+  else
+    dirty_y0 = std::min(dirty_y0, y0), dirty_y1 = std::max(dirty_y1, y1);
+}
+
+void MazeSharedPublisher::maybeFlush()
+{
+  if (std::chrono::steady_clock::now() - last_publish >= interval)
+    flush();
+}
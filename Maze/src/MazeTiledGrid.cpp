@@ -0,0 +1,275 @@
+#include "MazeTiledGrid.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  constexpr char TILE_MAGIC[4]{ 'M', 'Z', 'T', 'L' };
+  constexpr uint32_t TILE_VERSION = 1;
+  constexpr uint32_t MIN_TILE_SHIFT = 6;    // 64 x 64 個 byte 剛好一個 page，mmap 的 offset 要對齊 page
+  constexpr uint32_t MAX_TILE_SHIFT = 12;
+
+  struct TileFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t height, width;
+    uint32_t tile_shift;
+    uint32_t element_bytes;
+  };
+
+  bool pageAligned(const size_t bytes)
+  {
+#if defined(_WIN32)
+    (void)bytes;
+    return true;
+#else
+    return bytes % static_cast<size_t>(sysconf(_SC_PAGESIZE)) == 0;
+#endif
+  }
+}    // namespace
+
+/**
+ * @brief create a zero-filled tile file for a height x width grid and open it
+ */
+bool MazeTileCache::create(const std::string &path, const int32_t height, const int32_t width, const uint32_t element_bytes, const uint32_t tile_shift, const size_t resident_bytes)
+{
+  MAZE_TRACE_SCOPE("MazeTileCache::create");
+  close();
+  if (height <= 0 || width <= 0 || element_bytes == 0 || tile_shift < MIN_TILE_SHIFT || tile_shift > MAX_TILE_SHIFT)
+    return false;
+
+  setLayout(height, width, element_bytes, tile_shift);
+  if (!pageAligned(tile_bytes) || !openFile(path, true))
+    return false;
+
+  TileFileHeader header{};
+  std::memcpy(header.magic, TILE_MAGIC, sizeof(TILE_MAGIC));
+  header.version = TILE_VERSION;
+  header.height = height, header.width = width;
+  header.tile_shift = tile_shift;
+  header.element_bytes = element_bytes;
+  std::vector<uint8_t> page(HEADER_BYTES, 0);
+  std::memcpy(page.data(), &header, sizeof(header));
+
+  const uint64_t file_bytes = HEADER_BYTES + static_cast<uint64_t>(tile_rows) * tile_cols * tile_bytes;
+#if defined(_WIN32)
+  file.write(reinterpret_cast<const char *>(page.data()), HEADER_BYTES);    // tile 還沒讀到的部分當成 0
+  const bool sized = static_cast<bool>(file);
+  (void)file_bytes;
+#else
+  const bool sized = pwrite(fd, page.data(), HEADER_BYTES, 0) == static_cast<ssize_t>(HEADER_BYTES) && ftruncate(fd, static_cast<off_t>(file_bytes)) == 0;
+#endif
+  if (!sized) {
+    close();
+    return false;
+  }
+
+  setResidentLimit(resident_bytes);
+  return true;
+}
+
+/**
+ * @brief open an existing tile file, element_bytes has to match the one it was created with
+ */
+bool MazeTileCache::open(const std::string &path, const uint32_t element_bytes, const size_t resident_bytes)
+{
+  MAZE_TRACE_SCOPE("MazeTileCache::open");
+  close();
+  if (!openFile(path, false))
+    return false;
+
+  TileFileHeader header{};
+#if defined(_WIN32)
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  const bool read = static_cast<bool>(file);
+#else
+  const bool read = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+#endif
+  if (!read || std::memcmp(header.magic, TILE_MAGIC, sizeof(TILE_MAGIC)) != 0 || header.version != TILE_VERSION || header.height <= 0 || header.width <= 0
+      || header.element_bytes != element_bytes || header.tile_shift < MIN_TILE_SHIFT || header.tile_shift > MAX_TILE_SHIFT) {
+    close();
+    return false;
+  }
+
+  setLayout(header.height, header.width, header.element_bytes, header.tile_shift);
+  if (!pageAligned(tile_bytes)) {
+    close();
+    return false;
+  }
+
+  // 被截斷的檔案一定要在這裡擋掉，不然 mapping 超過檔尾的 tile 第一次碰到就是 SIGBUS
+  const uint64_t file_bytes = HEADER_BYTES + static_cast<uint64_t>(tile_rows) * tile_cols * tile_bytes;
+#if defined(_WIN32)
+  file.seekg(0, std::ios::end);
+  const bool complete = static_cast<uint64_t>(file.tellg()) >= file_bytes;
+  file.clear();
+#else
+  struct stat info;
+  const bool complete = fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) >= file_bytes;
+#endif
+  if (!complete) {
+    close();
+    return false;
+  }
+  setResidentLimit(resident_bytes);
+  return true;
+}
+
+/**
+ * @brief unmap every tile (their changes stay in the file) and close the file
+ */
+void MazeTileCache::close()
+{
+  for (Slot &slot : lru)
+    unmapTile(slot);
+  lru.clear();
+  resident.clear();
+  last_tile = SIZE_MAX;
+  last_data = nullptr;
+  tile_stats.resident_tiles = 0;
+
+#if defined(_WIN32)
+  if (file.is_open())
+    file.close();
+#else
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+#endif
+  is_open = false;
+}
+
+/**
+ * @brief how many bytes of tiles may be mapped at once, evicts down to it right away
+ */
+void MazeTileCache::setResidentLimit(const size_t bytes)
+{
+  max_tiles = std::max(tile_bytes ? bytes / tile_bytes : 0, MIN_RESIDENT_TILES);
+  while (lru.size() > max_tiles) {
+    unmapTile(lru.back());
+    resident.erase(lru.back().tile);
+    lru.pop_back();
+    ++tile_stats.evictions;
+  }
+  tile_stats.resident_tiles = lru.size();
+  last_tile = SIZE_MAX;
+}
+
+void MazeTileCache::resetStats()
+{
+  const uint64_t resident_tiles = tile_stats.resident_tiles;
+  tile_stats = MazeTileStats{};
+  tile_stats.tile_bytes = tile_bytes;
+  tile_stats.resident_tiles = tile_stats.peak_resident_tiles = resident_tiles;
+}
+
+/**
+ * @brief slow path of tile(): find the tile in the LRU or map it, evicting the least recently used tile when full
+ */
+uint8_t *MazeTileCache::lookup(const size_t index)
+{
+  const auto found = resident.find(index);
+  if (found != resident.end()) {
+    ++tile_stats.hits;
+    lru.splice(lru.begin(), lru, found->second);
+  }
+  else {
+    ++tile_stats.faults;
+    if (lru.size() >= max_tiles) {
+      Slot &victim = lru.back();
+      unmapTile(victim);
+      resident.erase(victim.tile);
+      lru.splice(lru.begin(), lru, std::prev(lru.end()));    // 重複使用這個 slot
+      ++tile_stats.evictions;
+    }
+    else {
+      lru.emplace_front();
+    }
+
+    Slot &slot = lru.front();
+    slot.tile = index;
+    if (!mapTile(slot)) {
+      lru.pop_front();
+      tile_stats.resident_tiles = lru.size();
+      throw std::bad_alloc();
+    }
+    resident.emplace(index, lru.begin());
+    tile_stats.resident_tiles = lru.size();
+    tile_stats.peak_resident_tiles = std::max(tile_stats.peak_resident_tiles, tile_stats.resident_tiles);
+  }
+
+  last_tile = index;
+  last_data = lru.front().data;
+  return last_data;
+}
+
+bool MazeTileCache::mapTile(Slot &slot)
+{
+  const uint64_t offset = HEADER_BYTES + static_cast<uint64_t>(slot.tile) * tile_bytes;
+#if defined(_WIN32)
+  slot.buffer.assign(tile_bytes, 0);
+  file.clear();
+  file.seekg(static_cast<std::streamoff>(offset));
+  file.read(reinterpret_cast<char *>(slot.buffer.data()), static_cast<std::streamsize>(tile_bytes));
+  file.clear();    // 檔案還沒寫到這裡的話讀不到東西，當成 0
+  slot.data = slot.buffer.data();
+  return true;
+#else
+  void *data = mmap(nullptr, tile_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+  if (data == MAP_FAILED)
+    return false;
+  slot.data = static_cast<uint8_t *>(data);
+  return true;
+#endif
+}
+
+void MazeTileCache::unmapTile(Slot &slot)
+{
+  if (!slot.data)
+    return;
+#if defined(_WIN32)
+  const uint64_t offset = HEADER_BYTES + static_cast<uint64_t>(slot.tile) * tile_bytes;
+  file.seekp(static_cast<std::streamoff>(offset));
+  file.write(reinterpret_cast<const char *>(slot.buffer.data()), static_cast<std::streamsize>(tile_bytes));
+#else
+  munmap(slot.data, tile_bytes);
+#endif
+  slot.data = nullptr;
+  if (slot.tile == last_tile)
+    last_tile = SIZE_MAX;
+}
+
+bool MazeTileCache::openFile(const std::string &path, const bool truncate)
+{
+#if defined(_WIN32)
+  auto mode = std::ios::binary | std::ios::in | std::ios::out;
+  file.open(path, truncate ? mode | std::ios::trunc : mode);
+  is_open = file.is_open();
+#else
+  fd = ::open(path.c_str(), truncate ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+  is_open = fd >= 0;
+#endif
+  return is_open;
+}
+
+void MazeTileCache::setLayout(const int32_t height, const int32_t width, const uint32_t element_bytes, const uint32_t tile_shift)
+{
+  const size_t side = size_t{ 1 } << tile_shift;
+  grid_height = height, grid_width = width;
+  this->tile_shift = tile_shift;
+  tile_rows = (static_cast<size_t>(height) + side - 1) >> tile_shift;
+  tile_cols = (static_cast<size_t>(width) + side - 1) >> tile_shift;
+  tile_bytes = side * side * element_bytes;
+  tile_stats = MazeTileStats{};
+  tile_stats.tile_bytes = tile_bytes;
+}
@@ -0,0 +1,155 @@
+#include "MazeTrace.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+  struct TraceEvent {
+    const char *name;
+    int64_t begin_us, end_us;
+  };
+
+  // 每個 thread 一個 buffer，寫入時只會鎖自己的 mutex，不會和其他 thread 搶
+  struct ThreadBuffer {
+    uint32_t tid;
+    std::string thread_name;
+    std::vector<TraceEvent> events;    // 滿了之後當成 ring buffer，next 是最舊的那個
+    size_t next = 0;
+    uint64_t dropped = 0;
+    std::mutex mtx;
+  };
+
+  struct TraceRegistry {
+    std::mutex mtx;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  };
+
+  TraceRegistry &registry()
+  {
+    static TraceRegistry instance;
+    return instance;
+  }
+
+  ThreadBuffer &threadBuffer()
+  {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+      auto new_buffer = std::make_shared<ThreadBuffer>();
+      TraceRegistry &reg = registry();
+      std::lock_guard<std::mutex> lock(reg.mtx);
+      new_buffer->tid = static_cast<uint32_t>(reg.buffers.size() + 1);
+      reg.buffers.push_back(new_buffer);
+      return new_buffer;
+    }();
+    return *buffer;
+  }
+
+  void writeEscaped(std::ostream &os, const char *text)
+  {
+    for (; *text; ++text) {
+      if (*text == '"' || *text == '\\') os << '\\';
+      os << *text;
+    }
+  }
+}    // namespace
+
+std::atomic<bool> MazeTrace::enabled{ false };
+
+void MazeTrace::setEnabled(const bool enable)
+{
+  registry();    // 先把時間原點定下來
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+int64_t MazeTrace::now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - registry().origin).count();
+}
+
+void MazeTrace::record(const char *name, const int64_t begin_us, const int64_t end_us)
+{
+  ThreadBuffer &buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mtx);
+  if (buffer.events.size() < MAX_EVENTS_PER_THREAD) {
+    buffer.events.push_back(TraceEvent{ name, begin_us, end_us });
+    return;
+  }
+  buffer.events[buffer.next] = TraceEvent{ name, begin_us, end_us };    // 蓋掉最舊的
+  buffer.next = (buffer.next + 1) % MAX_EVENTS_PER_THREAD;
+  ++buffer.dropped;
+}
+
+void MazeTrace::setThreadName(const char *name)
+{
+  ThreadBuffer &buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mtx);
+  buffer.thread_name = name;
+}
+
+/**
+ * @brief write every recorded event as complete ("X") events of a Chrome trace JSON file
+ *
+ * otherData.dropped_events is the number of events overwritten because a thread went past MAX_EVENTS_PER_THREAD.
+ *
+ * @return false if the file could not be opened
+ */
+bool MazeTrace::save(const std::string &path)
+{
+  std::ofstream os(path);
+  if (!os)
+    return false;
+
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> registry_lock(reg.mtx);
+
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  uint64_t dropped = 0;
+  for (const auto &buffer : reg.buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mtx);
+    if (!buffer->thread_name.empty()) {
+      os << (first ? "" : ",") << "\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":\"thread_name\",\"args\":{\"name\":\"";
+      writeEscaped(os, buffer->thread_name.c_str());
+      os << "\"}}";
+      first = false;
+    }
+    dropped += buffer->dropped;
+    for (size_t i = 0; i < buffer->events.size(); ++i) {
+      const TraceEvent &event = buffer->events[(buffer->next + i) % buffer->events.size()];    // 從最舊的開始
+      os << (first ? "" : ",") << "\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":" << event.begin_us << ",\"dur\":" << event.end_us - event.begin_us << ",\"name\":\"";
+      writeEscaped(os, event.name);
+      os << "\"}";
+      first = false;
+    }
+  }
+  os << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+
+  return static_cast<bool>(os);
+}
+
+void MazeTrace::clear()
+{
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> registry_lock(reg.mtx);
+  for (const auto &buffer : reg.buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mtx);
+    buffer->events.clear();
+    buffer->next = 0;
+    buffer->dropped = 0;
+  }
+}
+
+uint64_t MazeTrace::droppedEvents()
+{
+  TraceRegistry &reg = registry();
+  std::lock_guard<std::mutex> registry_lock(reg.mtx);
+  uint64_t dropped = 0;
+  for (const auto &buffer : reg.buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mtx);
+    dropped += buffer->dropped;
+  }
+  return dropped;
+}
@@ -1,6 +1,7 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
+#include "implot.h"
 #include <stdio.h>
 #include "glad/glad.h"
 #define GL_SILENCE_DEPRECATION
@@ -9,81 +10,799 @@
 #endif
 #include <GLFW/glfw3.h>
 
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
 #include "MazeController.h"
 #include "MazeModel.h"
 #include "MazeView.h"
 #include "MazeNode.h"
+#include "MazeTrace.h"
 
 MazeView::MazeView(uint32_t height, uint32_t width)
-    : render_maze{ height, std::vector<MazeElement>{ width, MazeElement::GROUND } }, update_node{ MazeNode{ -1, -1, MazeElement::INVALID } }, stop_flag{ false } {}
+    : render_maze{ static_cast<int32_t>(height), static_cast<int32_t>(width), MazeElement::GROUND }, MazeDiffQueue{ DIFF_QUEUE_CAPACITY }, batch_span_pos{ 0 }, batch_cell_pos{ 0 }, batch_in_progress{ false }, update_node{ MazeNode{ -1, -1, MazeElement::INVALID } }, stop_flag{ false }, trace_flag{ false }, playback_mode{ PlaybackMode::DIFFS_PER_FRAME }, diffs_per_frame{ 1 }, frame_budget_ms{ 4.0f }, stats_metric{ 0 }, maze_texture{ 0 },
+      tile_rows{ static_cast<int32_t>((height + TILE_SIZE - 1) / TILE_SIZE) }, tile_cols{ static_cast<int32_t>((width + TILE_SIZE - 1) / TILE_SIZE) },
+      dirty_tiles((static_cast<size_t>(tile_rows) * tile_cols + 63) / 64, 0),
+      zoom{ DEFAULT_CELL_SIZE }, pan_y{ 0.0f }, pan_x{ 0.0f }, fit_request{ false },
+      window_level{ -1 }, window_y{ 0 }, window_x{ 0 }, window_h{ 0 }, window_w{ 0 }, texture_h{ 0 }, texture_w{ 0 },
+      record_flag{ false }, replay_mode{ false }, replay_playing{ false }, replay_position{ 0 }, export_solution{ true },
+      heatmap_flag{ false }, heatmap_version{ 0 }, heatmap_window{ -1, 0, 0, 0, 0 }, heatmap_colormap{ -1 }
+{
+  markAllDirty();
+  buildPyramid();
+}
+
+namespace {
+  // IM_COL32 在 little endian 上的 byte 順序剛好是 R, G, B, A，可以直接當 GL_RGBA 上傳
+  uint32_t elementColor(const MazeElement element)
+  {
+    switch (element) {
+    case MazeElement::BEGIN: return IM_COL32(35, 220, 130, 255);
+    case MazeElement::END: return IM_COL32(250, 50, 150, 255);
+    case MazeElement::WALL: return IM_COL32(115, 64, 70, 255);
+    case MazeElement::GROUND: return IM_COL32(255, 255, 255, 255);
+    case MazeElement::EXPLORED: return IM_COL32(231, 158, 79, 255);
+    case MazeElement::PATH: return IM_COL32(60, 120, 230, 255);
+    default: return IM_COL32(0, 0, 0, 255);
+    }
+  }
+}    // namespace
 
 void MazeView::setController(MazeController *controller_ptr)
 {
   this->controller_ptr = controller_ptr;
 }
 
-void MazeView::setFrameMaze(const std::vector<std::vector<MazeElement>> &maze)
+/**
+ * @brief show a full grid sent by the model, after every diff sent before it
+ *
+ * @return false if the job was cancelled while waiting for the view to catch up
+ */
+bool MazeView::setFrameMaze(const MazeGrid &maze, const std::atomic<bool> *cancel)
 {
+  MAZE_TRACE_SCOPE("setFrameMaze");
+  // 先等畫面把之前送出的 diff 都套用完，不然舊的 diff 會蓋在新的圖上面
+  while (!MazeDiffQueue.empty() || batch_in_progress.load()) {
+    if (cancel && cancel->load(std::memory_order_relaxed))
+      return false;
+    std::this_thread::yield();
+  }
+
   std::lock_guard<std::mutex> lock(maze_mutex);
-  render_maze = maze;
+  copyFrame(maze);
+  return true;
 }
 
-void MazeView::enFramequeue(const MazeNode &node)
+/**
+ * @brief replace render_maze with maze, marking only the tiles whose cells actually changed, caller holds maze_mutex
+ */
+void MazeView::copyFrame(const MazeGrid &maze)
 {
-  MazeDiffQueue.enqueue(node);
+  if (!maze.sameShape(render_maze)) {    // 讀進來不同大小的迷宮
+    render_maze = maze;
+    resizeTiles();
+    markAllDirty();
+    buildPyramid();
+    window_level = -1;
+    return;
+  }
+
+  for (int32_t y = 0; y < maze.height(); ++y) {
+    const MazeElement *src = maze[y];
+    MazeElement *dst = render_maze[y];
+    const size_t width = static_cast<size_t>(maze.width());
+    for (size_t x = 0; x < width; x += TILE_SIZE) {
+      const size_t span = std::min<size_t>(TILE_SIZE, width - x);
+      if (!std::equal(src + x, src + x + span, dst + x)) {
+        std::copy(src + x, src + x + span, dst + x);
+        markDirty(y, static_cast<int32_t>(x));
+        updatePyramid(y, static_cast<int32_t>(x), y, static_cast<int32_t>(x + span - 1));
+      }
+    }
+  }
 }
 
+/**
+ * @brief push a batch, waiting while the queue is full (畫面暫停的時候會一直滿)
+ *
+ * @return false if the job was cancelled while waiting, the batch is dropped
+ */
+bool MazeView::enFramequeue(const MazeDiffBatch &batch, const std::atomic<bool> *cancel)
+{
+  while (!MazeDiffQueue.tryPush(batch)) {
+    if (cancel && cancel->load(std::memory_order_relaxed))
+      return false;
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+/**
+ * @brief apply this frame's share of the queued diffs, how many depends on the playback mode
+ *
+ * A row span counts as one diff, so a whole wall line shows up in one step.
+ */
 void MazeView::deFramequeue()
 {
-  std::optional<MazeNode> opt_node = MazeDiffQueue.dequeue();
-  if (opt_node.has_value()) {
-    update_node = *opt_node;
+  MAZE_TRACE_SCOPE("deFramequeue");
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto budget = std::chrono::duration<float, std::milli>(frame_budget_ms);
+
+  size_t limit = SIZE_MAX;
+  size_t batch_limit = SIZE_MAX;
+  if (playback_mode == PlaybackMode::DIFFS_PER_FRAME)
+    limit = static_cast<size_t>(diffs_per_frame);
+  else if (playback_mode == PlaybackMode::INSTANT)
+    batch_limit = MazeDiffQueue.size();    // 只追到這一幀開始時的狀態，producer 一直塞也不會卡住畫面
 
-    if (update_node.y != -1 && update_node.x != -1) {
-      std::lock_guard<std::mutex> lock(maze_mutex);
-      render_maze[update_node.y][update_node.x] = update_node.element;
+  std::lock_guard<std::mutex> lock(maze_mutex);
+  for (size_t applied = 0; applied < limit;) {
+    // 每一小段看一次時間，不用每個 diff 都去讀 clock
+    if (playback_mode == PlaybackMode::TIME_BUDGET && std::chrono::steady_clock::now() - start_time >= budget)
+      break;
+
+    if (!batch_in_progress.load(std::memory_order_relaxed)) {
+      if (batch_limit == 0)
+        break;
+      batch_in_progress.store(true);    // 要在 pop 之前設好，setFrameMaze 才不會看到 queue 空了卻還有一批沒套用
+      std::optional<MazeDiffBatch> batch = MazeDiffQueue.tryPop();
+      if (!batch.has_value()) {
+        batch_in_progress.store(false);
+        break;
+      }
+      current_batch = *batch;
+      batch_span_pos = batch_cell_pos = 0;
+      --batch_limit;
     }
+
+    applied += applyBatch(std::min(limit - applied, DIFF_CHUNK_SIZE));
+  }
+}
+
+/**
+ * @brief apply up to max_count diffs of current_batch, spans first and then cells, caller holds maze_mutex
+ *
+ * @return number of diffs applied
+ */
+size_t MazeView::applyBatch(const size_t max_count)
+{
+  const uint32_t width = static_cast<uint32_t>(levelWidth(0));
+  size_t count = 0;
+
+  for (; count < max_count && batch_span_pos < current_batch.span_count; ++count, ++batch_span_pos) {
+    const int32_t y = static_cast<int32_t>(current_batch.span_begin[batch_span_pos] / width);
+    const int32_t x = static_cast<int32_t>(current_batch.span_begin[batch_span_pos] % width);
+    const int32_t length = static_cast<int32_t>(current_batch.span_length[batch_span_pos]);
+    const MazeElement element = current_batch.span_element[batch_span_pos];
+
+    std::fill_n(render_maze[y] + x, length, element);
+    for (int32_t tile_x = x - x % TILE_SIZE; tile_x < x + length; tile_x += TILE_SIZE)
+      markDirty(y, tile_x);
+    updatePyramid(y, x, y, x + length - 1);
+    update_node = MazeNode{ y, x + length - 1, element };
   }
-  else if (controller_ptr->isModelComplete()) {
-    controller_ptr->handleInput(MazeAction::G_RESET);
+
+  for (; count < max_count && batch_cell_pos < current_batch.cell_count; ++count, ++batch_cell_pos) {
+    const uint32_t index = current_batch.cell_index[batch_cell_pos];
+    const MazeElement element = current_batch.cell_element[batch_cell_pos];
+    if (index == MazeDiffBatch::NO_CELL) {
+      update_node = MazeNode{ -1, -1, MazeElement::INVALID };
+      continue;
+    }
+
+    const int32_t y = static_cast<int32_t>(index / width), x = static_cast<int32_t>(index % width);
+    render_maze[y][x] = element;
+    markDirty(y, x);
+    updatePyramid(y, x, y, x);
+    update_node = MazeNode{ y, x, element };
   }
+
+  if (batch_span_pos == current_batch.span_count && batch_cell_pos == current_batch.cell_count)
+    batch_in_progress.store(false);
+  return count;
+}
+
+void MazeView::markDirty(const int32_t y, const int32_t x)
+{
+  const size_t tile = static_cast<size_t>(y / TILE_SIZE) * tile_cols + x / TILE_SIZE;
+  dirty_tiles[tile >> 6] |= uint64_t{ 1 } << (tile & 63);
 }
 
+// 迷宮大小變了，dirty bitset 跟著重配，texture 下一幀依新的大小重建
+void MazeView::resizeTiles()
+{
+  tile_rows = (render_maze.height() + TILE_SIZE - 1) / TILE_SIZE;
+  tile_cols = (render_maze.width() + TILE_SIZE - 1) / TILE_SIZE;
+  dirty_tiles.assign((static_cast<size_t>(tile_rows) * tile_cols + 63) / 64, 0);
+  fit_request = true;
+}
+
+void MazeView::markAllDirty()
+{
+  std::fill(dirty_tiles.begin(), dirty_tiles.end(), ~uint64_t{ 0 });
+  const size_t tail_bits = (static_cast<size_t>(tile_rows) * tile_cols) & 63;
+  if (tail_bits && !dirty_tiles.empty())
+    dirty_tiles.back() = (uint64_t{ 1 } << tail_bits) - 1;
+}
+
+int32_t MazeView::levelHeight(const int32_t level) const
+{
+  return static_cast<int32_t>((static_cast<size_t>(render_maze.height()) + (size_t{ 1 } << level) - 1) >> level);
+}
+
+int32_t MazeView::levelWidth(const int32_t level) const
+{
+  return static_cast<int32_t>((static_cast<size_t>(render_maze.width()) + (size_t{ 1 } << level) - 1) >> level);
+}
+
+uint32_t MazeView::levelColor(const int32_t level, const int32_t y, const int32_t x) const
+{
+  if (level == 0)
+    return elementColor(render_maze[y][x]);
+  return pyramid[level - 1][static_cast<size_t>(y) * levelWidth(level) + x];
+}
+
+/**
+ * @brief allocate every level above the grid down to a single texel and fill them from render_maze
+ */
+void MazeView::buildPyramid()
+{
+  MAZE_TRACE_SCOPE("buildPyramid");
+  pyramid.clear();
+  for (int32_t level = 1; levelHeight(level - 1) > 1 || levelWidth(level - 1) > 1; ++level)
+    pyramid.emplace_back(static_cast<size_t>(levelHeight(level)) * levelWidth(level));
+
+  if (!render_maze.empty())
+    updatePyramid(0, 0, levelHeight(0) - 1, levelWidth(0) - 1);
+}
+
+/**
+ * @brief recompute the texels above the inclusive cell rectangle [y0, y1] x [x0, x1], level by level up to the top
+ *
+ * A single diff only touches one texel per level, so it costs O(levels). Large rectangles (a whole new frame)
+ * split each level's rows across the thread pool, the levels themselves still go one after another.
+ */
+void MazeView::updatePyramid(int32_t y0, int32_t x0, int32_t y1, int32_t x1)
+{
+  for (int32_t level = 1; level <= static_cast<int32_t>(pyramid.size()); ++level) {
+    y0 >>= 1, x0 >>= 1, y1 >>= 1, x1 >>= 1;
+    const int32_t child_h = levelHeight(level - 1), child_w = levelWidth(level - 1);
+    const int32_t width = levelWidth(level);
+
+    auto average_rows = [&](const size_t row_begin, const size_t row_end) {
+      for (int32_t y = static_cast<int32_t>(row_begin); y < static_cast<int32_t>(row_end); ++y) {
+        for (int32_t x = x0; x <= x1; ++x) {
+          uint32_t r = 0, g = 0, b = 0, count = 0;
+          for (int32_t cy = 2 * y; cy < std::min(2 * y + 2, child_h); ++cy) {
+            for (int32_t cx = 2 * x; cx < std::min(2 * x + 2, child_w); ++cx) {
+              const uint32_t color = levelColor(level - 1, cy, cx);
+              r += (color >> IM_COL32_R_SHIFT) & 0xFF;
+              g += (color >> IM_COL32_G_SHIFT) & 0xFF;
+              b += (color >> IM_COL32_B_SHIFT) & 0xFF;
+              ++count;
+            }
+          }
+          pyramid[level - 1][static_cast<size_t>(y) * width + x] = IM_COL32(r / count, g / count, b / count, 255);
+        }
+      }
+    };
+
+    const size_t rows = static_cast<size_t>(y1 - y0 + 1), cols = static_cast<size_t>(x1 - x0 + 1);
+    if (controller_ptr && rows * cols >= PARALLEL_PYRAMID_TEXELS)
+      controller_ptr->threadPool().parallelFor(y0, y1 + 1, std::max<size_t>(PARALLEL_PYRAMID_TEXELS / 4 / cols, 1), average_rows);
+    else
+      average_rows(y0, y1 + 1);
+  }
+}
+
+/**
+ * @brief make the texture hold texels [win_y, win_y + win_h) x [win_x, win_x + win_w) of the given level, caller holds maze_mutex
+ *
+ * If the window is the same as last frame only the dirty tiles inside it are uploaded, otherwise the whole window is.
+ */
+void MazeView::uploadWindow(const int32_t level, const int32_t win_y, const int32_t win_x, const int32_t win_h, const int32_t win_w)
+{
+  MAZE_TRACE_SCOPE("uploadWindow");
+  if (maze_texture == 0 || win_h > texture_h || win_w > texture_w) {
+    if (maze_texture == 0) {
+      GLuint texture;
+      glGenTextures(1, &texture);
+      maze_texture = texture;
+    }
+    texture_h = std::max(texture_h, win_h);
+    texture_w = std::max(texture_w, win_w);
+    glBindTexture(GL_TEXTURE_2D, maze_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_w, texture_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    window_level = -1;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, maze_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  // 上傳 level 座標下 [y0, y1) x [x0, x1) 這塊
+  const auto upload = [&](const int32_t y0, const int32_t x0, const int32_t y1, const int32_t x1) {
+    const int32_t rect_h = y1 - y0, rect_w = x1 - x0;
+    if (rect_h <= 0 || rect_w <= 0) return;
+    upload_buffer.resize(static_cast<size_t>(rect_h) * rect_w);
+    const size_t level_w = static_cast<size_t>(levelWidth(level));
+    for (int32_t y = 0; y < rect_h; ++y) {
+      uint32_t *out = upload_buffer.data() + static_cast<size_t>(y) * rect_w;
+      if (level == 0) {
+        const MazeElement *row = render_maze[y0 + y] + x0;
+        for (int32_t x = 0; x < rect_w; ++x)
+          out[x] = elementColor(row[x]);
+      }
+      else
+        std::copy_n(pyramid[level - 1].data() + (y0 + y) * level_w + x0, rect_w, out);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x0 - win_x, y0 - win_y, rect_w, rect_h, GL_RGBA, GL_UNSIGNED_BYTE, upload_buffer.data());
+  };
+
+  if (level != window_level || win_y != window_y || win_x != window_x || win_h != window_h || win_w != window_w) {
+    upload(win_y, win_x, win_y + win_h, win_x + win_w);
+    window_level = level, window_y = win_y, window_x = win_x, window_h = win_h, window_w = win_w;
+    std::fill(dirty_tiles.begin(), dirty_tiles.end(), 0);
+    return;
+  }
+
+  for (size_t word = 0; word < dirty_tiles.size(); ++word) {
+    // 整個 word 都是 0 就直接跳過，大部分時間只有少數幾個 tile 有變
+    for (uint64_t bits = dirty_tiles[word]; bits != 0; bits &= bits - 1) {
+      int32_t bit = 0;
+      while (!((bits >> bit) & 1)) ++bit;
+      const int32_t tile = static_cast<int32_t>(word * 64) + bit;
+      const int32_t tile_y = tile / tile_cols * TILE_SIZE, tile_x = tile % tile_cols * TILE_SIZE;
+
+      // tile 換算到這一層，再裁到 window 裡
+      const int32_t y0 = std::max(tile_y >> level, win_y), x0 = std::max(tile_x >> level, win_x);
+      const int32_t y1 = std::min(((tile_y + TILE_SIZE - 1) >> level) + 1, win_y + win_h);
+      const int32_t x1 = std::min(((tile_x + TILE_SIZE - 1) >> level) + 1, win_x + win_w);
+      upload(y0, x0, std::min(y1, levelHeight(level)), std::min(x1, levelWidth(level)));
+    }
+    dirty_tiles[word] = 0;
+  }
+}
+
+void MazeView::releaseTexture()
+{
+  if (maze_texture != 0) {
+    GLuint texture = maze_texture;
+    glDeleteTextures(1, &texture);
+    maze_texture = 0;
+    window_level = -1;
+    texture_h = texture_w = 0;
+  }
+}
+
+/**
+ * @brief mouse wheel and +/- zoom around the cursor (or the centre), dragging and the arrow keys pan, Home fits the whole maze
+ */
+void MazeView::handleViewportInput(const ImVec2 &origin, const ImVec2 &view_size)
+{
+  const ImGuiIO &io = ImGui::GetIO();
+  const float height = static_cast<float>(render_maze.height());
+  const float width = static_cast<float>(render_maze.width());
+  const float fit_zoom = std::min(view_size.x / std::max(width, 1.0f), view_size.y / std::max(height, 1.0f));
+  const float min_zoom = std::min(fit_zoom * 0.5f, DEFAULT_CELL_SIZE);
+
+  const bool focused = ImGui::IsWindowFocused();
+  if (fit_request || (focused && ImGui::IsKeyPressed(ImGuiKey_Home))) {
+    zoom = std::min(fit_zoom, MAX_CELL_SIZE);
+    pan_y = pan_x = 0.0f;
+    fit_request = false;
+  }
+
+  const auto zoomAround = [&](const ImVec2 &anchor, const float factor) {
+    const float anchor_y = pan_y + (anchor.y - origin.y) / zoom;
+    const float anchor_x = pan_x + (anchor.x - origin.x) / zoom;
+    zoom = std::clamp(zoom * factor, min_zoom, MAX_CELL_SIZE);
+    pan_y = anchor_y - (anchor.y - origin.y) / zoom;
+    pan_x = anchor_x - (anchor.x - origin.x) / zoom;
+  };
+
+  if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f)
+    zoomAround(io.MousePos, std::pow(1.2f, io.MouseWheel));
+  if (ImGui::IsItemActive() && (ImGui::IsMouseDragging(ImGuiMouseButton_Left) || ImGui::IsMouseDragging(ImGuiMouseButton_Middle))) {
+    pan_y -= io.MouseDelta.y / zoom;
+    pan_x -= io.MouseDelta.x / zoom;
+  }
+
+  if (focused) {
+    const ImVec2 centre = ImVec2(origin.x + view_size.x * 0.5f, origin.y + view_size.y * 0.5f);
+    const float step = 600.0f * io.DeltaTime / zoom;    // 每秒 600 pixel
+    if (ImGui::IsKeyDown(ImGuiKey_LeftArrow)) pan_x -= step;
+    if (ImGui::IsKeyDown(ImGuiKey_RightArrow)) pan_x += step;
+    if (ImGui::IsKeyDown(ImGuiKey_UpArrow)) pan_y -= step;
+    if (ImGui::IsKeyDown(ImGuiKey_DownArrow)) pan_y += step;
+    if (ImGui::IsKeyPressed(ImGuiKey_Equal) || ImGui::IsKeyPressed(ImGuiKey_KeypadAdd)) zoomAround(centre, 1.25f);
+    if (ImGui::IsKeyPressed(ImGuiKey_Minus) || ImGui::IsKeyPressed(ImGuiKey_KeypadSubtract)) zoomAround(centre, 0.8f);
+  }
+
+  // 至少留半個畫面的迷宮在視窗裡
+  pan_y = std::clamp(pan_y, -view_size.y * 0.5f / zoom, std::max(height - view_size.y * 0.5f / zoom, 0.0f));
+  pan_x = std::clamp(pan_x, -view_size.x * 0.5f / zoom, std::max(width - view_size.x * 0.5f / zoom, 0.0f));
+}
+
+/**
+ * @brief draw the visible part of the grid as one textured quad
+ *
+ * Only the cells inside the viewport are uploaded. When a cell is smaller than a pixel the quad samples the
+ * pyramid level where one texel covers at least one pixel, so the texture never gets larger than the viewport.
+ */
 void MazeView::renderMaze()
 {
+  MAZE_TRACE_SCOPE("renderMaze");
   ImDrawList *draw_list = ImGui::GetWindowDrawList();
   const ImVec2 p = ImGui::GetCursorScreenPos();
-  const float cell_size = 15.0f;
+  const ImVec2 view_size = ImVec2(std::max(ImGui::GetContentRegionAvail().x, 1.0f), std::max(ImGui::GetContentRegionAvail().y, 1.0f));
+  ImGui::InvisibleButton("maze_canvas", view_size, ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonMiddle);
+
+  std::lock_guard<std::mutex> lock(maze_mutex);
+  handleViewportInput(p, view_size);
+  updateHeatmap();
+
+  const int32_t height = levelHeight(0), width = levelWidth(0);
+  const int32_t cell_y0 = std::max(0, static_cast<int32_t>(std::floor(pan_y)));
+  const int32_t cell_x0 = std::max(0, static_cast<int32_t>(std::floor(pan_x)));
+  const int32_t cell_y1 = std::min(height, static_cast<int32_t>(std::ceil(pan_y + view_size.y / zoom)));
+  const int32_t cell_x1 = std::min(width, static_cast<int32_t>(std::ceil(pan_x + view_size.x / zoom)));
+  if (cell_y0 >= cell_y1 || cell_x0 >= cell_x1)
+    return;
+
+  int32_t level = 0;
+  while (level < static_cast<int32_t>(pyramid.size()) && zoom * static_cast<float>(1 << level) < 1.0f)
+    ++level;
+  const float texel_size = zoom * static_cast<float>(1 << level);
+  const int32_t win_y = cell_y0 >> level, win_x = cell_x0 >> level;
+  const int32_t win_h = ((cell_y1 - 1) >> level) - win_y + 1, win_w = ((cell_x1 - 1) >> level) - win_x + 1;
+  uploadWindow(level, win_y, win_x, win_h, win_w);
 
+  draw_list->PushClipRect(p, ImVec2(p.x + view_size.x, p.y + view_size.y), true);
+  const ImVec2 image_min = ImVec2(p.x + (static_cast<float>(win_x << level) - pan_x) * zoom, p.y + (static_cast<float>(win_y << level) - pan_y) * zoom);
+  const ImVec2 image_max = ImVec2(image_min.x + win_w * texel_size, image_min.y + win_h * texel_size);
+  draw_list->AddImage(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(maze_texture)), image_min, image_max,
+                      ImVec2(0.0f, 0.0f), ImVec2(static_cast<float>(win_w) / texture_w, static_cast<float>(win_h) / texture_h));
 
+  const auto cellMin = [&](const int32_t y, const int32_t x) {
+    return ImVec2(p.x + (static_cast<float>(x) - pan_x) * zoom, p.y + (static_cast<float>(y) - pan_y) * zoom);
+  };
+
+  // 格子太小的時候格線只會把畫面塗成灰色
+  if (zoom >= 6.0f) {
+    const ImVec2 grid_min = cellMin(cell_y0, cell_x0), grid_max = cellMin(cell_y1, cell_x1);
+    for (int32_t y = cell_y0; y <= cell_y1; ++y)
+      draw_list->AddLine(ImVec2(grid_min.x, cellMin(y, 0).y), ImVec2(grid_max.x, cellMin(y, 0).y), IM_COL32(100, 100, 100, 255));
+    for (int32_t x = cell_x0; x <= cell_x1; ++x)
+      draw_list->AddLine(ImVec2(cellMin(0, x).x, grid_min.y), ImVec2(cellMin(0, x).x, grid_max.y), IM_COL32(100, 100, 100, 255));
+  }
+
+  if (update_node.y >= cell_y0 && update_node.y < cell_y1 && update_node.x >= cell_x0 && update_node.x < cell_x1) {
+    const ImVec2 cell_min = cellMin(update_node.y, update_node.x);
+    const float size = std::max(zoom, 2.0f);    // 縮小的時候還是要看得到
+    draw_list->AddRectFilled(cell_min, ImVec2(cell_min.x + size, cell_min.y + size), IM_COL32(50, 215, 250, 255));
+  }
+  draw_list->PopClipRect();
+
+  renderHeatmap(p, view_size, cell_y0, cell_x0, cell_y1, cell_x1);
+}
+
+/**
+ * @brief take the layer the controller published after the last search, if it changed since the last frame
+ */
+void MazeView::updateHeatmap()
+{
+  uint64_t version;
+  std::shared_ptr<const MazeExpansionLayer> layer = controller_ptr->getHeatmap(version);
+  if (version == heatmap_version)
+    return;
+
+  heatmap_version = version;
+  heatmap_layer = std::move(layer);
+  buildHeatmapPyramid();
+  heatmap_window[0] = -1;
+}
+
+/**
+ * @brief the min pyramid of the expansion order, one level per halving like the colour pyramid of the maze
+ *
+ * A texel keeps the earliest expansion below it, so zooming out shows how far the search had got by then instead of
+ * averaging it away. 0 (not expanded) never wins.
+ */
+void MazeView::buildHeatmapPyramid()
+{
+  MAZE_TRACE_SCOPE("buildHeatmapPyramid");
+  heatmap_pyramid.clear();
+  if (!heatmap_layer || heatmap_layer->height != render_maze.height() || heatmap_layer->width != render_maze.width())
+    return;
+
+  for (int32_t level = 1; levelHeight(level - 1) > 1 || levelWidth(level - 1) > 1; ++level) {
+    heatmap_pyramid.emplace_back(static_cast<size_t>(levelHeight(level)) * levelWidth(level));
+    const int32_t child_h = levelHeight(level - 1), child_w = levelWidth(level - 1);
+    const int32_t width = levelWidth(level);
+
+    auto min_rows = [&](const size_t row_begin, const size_t row_end) {
+      for (int32_t y = static_cast<int32_t>(row_begin); y < static_cast<int32_t>(row_end); ++y) {
+        for (int32_t x = 0; x < width; ++x) {
+          uint32_t earliest = 0;
+          for (int32_t cy = 2 * y; cy < std::min(2 * y + 2, child_h); ++cy) {
+            for (int32_t cx = 2 * x; cx < std::min(2 * x + 2, child_w); ++cx) {
+              const uint32_t order = heatmapOrder(level - 1, cy, cx);
+              if (order && (!earliest || order < earliest))
+                earliest = order;
+            }
+          }
+          heatmap_pyramid[level - 1][static_cast<size_t>(y) * width + x] = earliest;
+        }
+      }
+    };
+
+    const size_t rows = static_cast<size_t>(levelHeight(level));
+    if (rows * width >= PARALLEL_PYRAMID_TEXELS)
+      controller_ptr->threadPool().parallelFor(0, rows, std::max<size_t>(PARALLEL_PYRAMID_TEXELS / 4 / width, 1), min_rows);
+    else
+      min_rows(0, rows);
+  }
+}
+
+uint32_t MazeView::heatmapOrder(const int32_t level, const int32_t y, const int32_t x) const
+{
+  if (level == 0)
+    return heatmap_layer->order[static_cast<size_t>(y) * levelWidth(0) + x];
+  return heatmap_pyramid[level - 1][static_cast<size_t>(y) * levelWidth(level) + x];
+}
+
+/**
+ * @brief draw the expansion order of the last search over the visible cells with ImPlot's PlotHeatmap
+ *
+ * The plot is a transparent, input-less canvas laid exactly over the maze, its axes are the cell coordinates of the
+ * viewport. At most HEATMAP_BINS texels per side are drawn, from the pyramid level that fits, and they are only
+ * recomputed when the visible texels or the layer change. Cells the search did not expand stay transparent.
+ */
+void MazeView::renderHeatmap(const ImVec2 &origin, const ImVec2 &view_size, const int32_t cell_y0, const int32_t cell_x0, const int32_t cell_y1, const int32_t cell_x1)
+{
+  if (!heatmap_flag || !heatmap_layer || heatmap_layer->height != render_maze.height() || heatmap_layer->width != render_maze.width())
+    return;
+  MAZE_TRACE_SCOPE("renderHeatmap");
+
+  int32_t level = 0;
+  while (level < static_cast<int32_t>(heatmap_pyramid.size()) && std::max(cell_y1 - cell_y0, cell_x1 - cell_x0) > (HEATMAP_BINS << level))
+    ++level;
+  const int32_t tex_y0 = cell_y0 >> level, tex_x0 = cell_x0 >> level;
+  const int32_t tex_y1 = (cell_y1 - 1) >> level, tex_x1 = (cell_x1 - 1) >> level;
+  const int32_t rows = tex_y1 - tex_y0 + 1, cols = tex_x1 - tex_x0 + 1;
+
+  const std::array<int32_t, 5> window{ level, tex_y0, tex_x0, tex_y1, tex_x1 };
+  if (window != heatmap_window) {
+    heatmap_window = window;
+    heatmap_bins.resize(static_cast<size_t>(rows) * cols);
+    const uint64_t span = std::max<uint64_t>(heatmap_layer->expanded, 2) - 1;
+    for (int32_t y = 0; y < rows; ++y) {
+      for (int32_t x = 0; x < cols; ++x) {
+        const uint32_t order = heatmapOrder(level, tex_y0 + y, tex_x0 + x);
+        const uint64_t color = order ? 1 + (order - uint64_t{ 1 }) * (HEATMAP_COLORS - 2) / span : 0;
+        heatmap_bins[static_cast<size_t>(y) * cols + x] = static_cast<float>(color) + 0.5f;    // 放在色塊中間，qualitative colormap 直接取整數
+      }
+    }
+  }
+
+  if (heatmap_colormap == -1)
+    heatmap_colormap = ImPlot::GetColormapIndex("Expansion");
+  if (heatmap_colormap == -1) {
+    ImVec4 colors[HEATMAP_COLORS];
+    colors[0] = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int32_t i = 1; i < HEATMAP_COLORS; ++i) {
+      colors[i] = ImPlot::SampleColormap(static_cast<float>(i - 1) / (HEATMAP_COLORS - 2), ImPlotColormap_Viridis);
+      colors[i].w = 0.65f;    // 底下的牆還看得到
+    }
+    heatmap_colormap = ImPlot::AddColormap("Expansion", colors, HEATMAP_COLORS, true);
+  }
+
+  // 縱軸用 -y，heatmap 的第 0 列畫在上面，和迷宮同一個方向
+  const double bound_y1 = std::min(static_cast<double>((tex_y1 + 1) << level), static_cast<double>(render_maze.height()));
+  const double bound_x1 = std::min(static_cast<double>((tex_x1 + 1) << level), static_cast<double>(render_maze.width()));
+  ImGui::SetCursorScreenPos(origin);
+  ImPlot::PushStyleVar(ImPlotStyleVar_PlotPadding, ImVec2(0.0f, 0.0f));
+  ImPlot::PushStyleVar(ImPlotStyleVar_PlotBorderSize, 0.0f);
+  ImPlot::PushStyleColor(ImPlotCol_PlotBg, ImVec4(0.0f, 0.0f, 0.0f, 0.0f));
+  if (ImPlot::BeginPlot("##heatmap", view_size, ImPlotFlags_CanvasOnly | ImPlotFlags_NoInputs | ImPlotFlags_NoFrame)) {
+    ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
+    ImPlot::SetupAxesLimits(pan_x, pan_x + view_size.x / zoom, -(pan_y + view_size.y / zoom), -pan_y, ImPlotCond_Always);
+    ImPlot::PushColormap(heatmap_colormap);
+    ImPlot::PlotHeatmap("##order", heatmap_bins.data(), rows, cols, 0.0, HEATMAP_COLORS, nullptr,
+                        ImPlotPoint(static_cast<double>(tex_x0 << level), -bound_y1), ImPlotPoint(bound_x1, -static_cast<double>(tex_y0 << level)));
+    ImPlot::PopColormap();
+    ImPlot::EndPlot();
+  }
+  ImPlot::PopStyleColor();
+  ImPlot::PopStyleVar(2);
+}
+
+/**
+ * @brief job policy, what is running and how many are waiting, and a button to cancel them all
+ */
+void MazeView::renderJobs()
+{
+  static constexpr const char *policy_name[]{ "Cancel previous", "Queue" };
+  int32_t policy = static_cast<int32_t>(controller_ptr->getJobPolicy());
+  ImGui::SetNextItemWidth(200.0f);
+  if (ImGui::Combo("New action", &policy, policy_name, IM_ARRAYSIZE(policy_name)))
+    controller_ptr->setJobPolicy(static_cast<JobPolicy>(policy));
+
+  const MazeJobHandle job = controller_ptr->currentJob();
+  const size_t pending = controller_ptr->pendingJobs();
+  if (job)
+    ImGui::Text("Running %s%s, %zu queued", job->name().c_str(), job->isCancelled() ? " (cancelling)" : "", pending);
+  else
+    ImGui::Text("Idle, %zu queued", pending);
+  ImGui::SameLine();
+  ImGui::BeginDisabled(!job && pending == 0);
+  if (ImGui::Button("Cancel")) controller_ptr->cancelJobs();
+  ImGui::EndDisabled();
+}
+
+/**
+ * @brief image export (format, pixels per cell, last solution) and import (cell size, wall threshold), both run as jobs
+ */
+void MazeView::renderExport()
+{
+  static constexpr const char *format_name[]{ "PGM", "PPM", "PNG" };
+  int32_t format = static_cast<int32_t>(export_options.format);
+  ImGui::SetNextItemWidth(80.0f);
+  if (ImGui::Combo("##format", &format, format_name, IM_ARRAYSIZE(format_name)))
+    export_options.format = static_cast<ImageFormat>(format);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(100.0f);
+  ImGui::SliderInt("px/cell", &export_options.pixels_per_cell, 1, 16);
+  ImGui::SameLine();
+  ImGui::Checkbox("Solution", &export_solution);
+  ImGui::SameLine();
+  if (ImGui::Button("Export image"))
+    controller_ptr->exportImage(std::string(MazeController::IMAGE_PATH) + MazeImage::extension(export_options.format), export_options, export_solution);
+
+  ImGui::SetNextItemWidth(100.0f);
+  ImGui::SliderInt("px/cell##import", &import_options.pixels_per_cell, 1, 16);
+  ImGui::SameLine();
+  int32_t threshold = import_options.wall_threshold;
+  ImGui::SetNextItemWidth(100.0f);
+  if (ImGui::SliderInt("Wall below", &threshold, 1, 255))
+    import_options.wall_threshold = static_cast<uint8_t>(threshold);
+  ImGui::SameLine();
+  if (ImGui::Button("Import image"))
+    controller_ptr->importImage(MazeController::IMPORT_PATH, import_options);
+}
+
+/**
+ * @brief heatmap toggle and export, the export uses the format and pixels per cell of the image export
+ */
+void MazeView::renderHeatmapControls()
+{
+  if (ImGui::Checkbox("Heatmap", &heatmap_flag))
+    controller_ptr->setHeatmap(heatmap_flag);
+  ImGui::SameLine();
+  ImGui::BeginDisabled(!heatmap_flag);
+  if (ImGui::Button("Export heatmap"))
+    controller_ptr->exportHeatmap(MazeController::HEATMAP_PATH, export_options);
+  ImGui::EndDisabled();
+  if (heatmap_flag && heatmap_layer) {
+    ImGui::SameLine();
+    ImGui::Text("%u cells expanded", heatmap_layer->expanded);
+  }
+}
+
+/**
+ * @brief record toggle, open / close a recorded run, and the slider that scrubs through it
+ */
+void MazeView::renderReplay()
+{
+  if (ImGui::Checkbox("Record", &record_flag))
+    controller_ptr->setRecording(record_flag);
+  ImGui::SameLine();
+
+  if (!replay_mode) {
+    ImGui::BeginDisabled(controller_ptr->isJobRunning());
+    if (ImGui::Button("Open replay")) {
+      if (!replay.open(MazeController::REPLAY_PATH) || replay.height() != levelHeight(0) || replay.width() != levelWidth(0))
+        std::clog << "failed to read " << MazeController::REPLAY_PATH << std::endl;
+      else {
+        {
+          std::lock_guard<std::mutex> lock(maze_mutex);
+          live_maze = render_maze;
+        }
+        replay_mode = true;
+        replay_playing = false;
+        showReplay(replay.diffCount());
+      }
+    }
+    ImGui::EndDisabled();
+    return;
+  }
+
+  if (ImGui::Button("Close replay")) {
+    replay.close();
+    replay_mode = false;
+    std::lock_guard<std::mutex> lock(maze_mutex);
+    copyFrame(live_maze);
+    update_node = MazeNode{ -1, -1, MazeElement::INVALID };
+    return;
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("Play", &replay_playing);
+  ImGui::SameLine();
+  ImGui::Text("%s, seed %u", maze_action_name[static_cast<int32_t>(replay.action())], replay.seed());
+
+  uint64_t position = replay_position;
+  if (replay_playing) {    // 播放速度和即時畫面一樣用 diffs per frame
+    position = std::min(position + static_cast<uint64_t>(diffs_per_frame), replay.diffCount());
+    replay_playing = position < replay.diffCount();
+  }
+
+  const uint64_t zero = 0, diff_count = replay.diffCount();
+  ImGui::SetNextItemWidth(400.0f);
+  ImGui::SliderScalar("Replay", ImGuiDataType_U64, &position, &zero, &diff_count);
+  if (position != replay_position)
+    showReplay(position);
+}
+
+void MazeView::showReplay(const uint64_t position)
+{
+  if (!replay.seek(position, replay_maze)) {
+    std::clog << "failed to read " << MazeController::REPLAY_PATH << std::endl;
+    return;
+  }
+
+  replay_position = position;
   std::lock_guard<std::mutex> lock(maze_mutex);
-  for (int32_t y = 0; y < MAZE_HEIGHT; ++y) {
-    for (int32_t x = 0; x < MAZE_WIDTH; ++x) {
-      MazeElement cell = render_maze[y][x];
-      ImVec2 cell_min = ImVec2(p.x + x * cell_size, p.y + y * cell_size);
-      ImVec2 cell_max = ImVec2(cell_min.x + cell_size, cell_min.y + cell_size);
-
-      if (update_node.y == y && update_node.x == x)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(50, 215, 250, 255));
-      else if (cell == MazeElement::BEGIN)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(35, 220, 130, 255));
-      else if (cell == MazeElement::END)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(250, 50, 150, 255));
-      else if (cell == MazeElement::WALL)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(115, 64, 70, 255));
-      else if (cell == MazeElement::GROUND)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(255, 255, 255, 255));
-      else if (cell == MazeElement::EXPLORED)
-        draw_list->AddRectFilled(cell_min, cell_max, IM_COL32(231, 158, 79, 255));
-
-      draw_list->AddRect(cell_min, cell_max, IM_COL32(100, 100, 100, 255));
+  copyFrame(replay_maze);
+  update_node = MazeNode{ -1, -1, MazeElement::INVALID };
+}
+
+/**
+ * @brief bar chart of the chosen counter for the last run of every generator and solver
+ */
+void MazeView::renderStats()
+{
+  static constexpr const char *metric_name[]{ "Nodes expanded", "Pushes", "Pops", "Peak open list", "Peak memory (KiB)", "Path length", "Time (ms)" };
+  constexpr int32_t algorithm_count = MAZE_ACTION_COUNT - 1;    // G_RESET 不算
+
+  double values[algorithm_count], positions[algorithm_count];
+  const char *labels[algorithm_count];
+  for (int32_t i = 0; i < algorithm_count; ++i) {
+    const MazeAction action = static_cast<MazeAction>(i + 1);
+    const MazeStats stats = controller_ptr->getStats(action);
+    switch (stats_metric) {
+    case 0: values[i] = static_cast<double>(stats.nodes_expanded); break;
+    case 1: values[i] = static_cast<double>(stats.pushes); break;
+    case 2: values[i] = static_cast<double>(stats.pops); break;
+    case 3: values[i] = static_cast<double>(stats.peak_open); break;
+    case 4: values[i] = static_cast<double>(stats.peak_memory) / 1024.0; break;
+    case 5: values[i] = static_cast<double>(stats.path_length); break;
+    default: values[i] = stats.elapsed_ms; break;
     }
+    positions[i] = i;
+    labels[i] = maze_action_name[i + 1];
+  }
+
+  ImGui::SetNextItemWidth(200.0f);
+  ImGui::Combo("Metric", &stats_metric, metric_name, IM_ARRAYSIZE(metric_name));
+  if (ImPlot::BeginPlot("Last run", ImVec2(400, 300), ImPlotFlags_NoLegend)) {
+    ImPlot::SetupAxes(metric_name[stats_metric], nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_Invert);
+    ImPlot::SetupAxisTicks(ImAxis_Y1, positions, algorithm_count, labels);
+    ImPlot::PlotBars(metric_name[stats_metric], values, algorithm_count, 0.67, 0, ImPlotBarsFlags_Horizontal);
+    ImPlot::EndPlot();
   }
 }
 
 void MazeView::renderGUI()
 {
-  if (!stop_flag)
+  if (!stop_flag && !replay_mode)
     deFramequeue();
 
   ImGui::Begin("Maze Generator and Solver");
@@ -92,9 +811,53 @@ void MazeView::renderGUI()
   ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
               1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
   ImGui::Checkbox("Stop", &stop_flag);
+  ImGui::SameLine();
+  if (ImGui::Button("Fit")) fit_request = true;
+  ImGui::SameLine();
+  ImGui::Text("%.2f px/cell, LOD %d", zoom, std::max(window_level, 0));
+  ImGui::SameLine();
+  if (ImGui::Checkbox("Trace", &trace_flag)) MazeTrace::setEnabled(trace_flag);
+  ImGui::SameLine();
+  if (ImGui::Button("Save trace")) {
+    if (!MazeTrace::save("maze_trace.json"))
+      std::clog << "failed to write maze_trace.json" << std::endl;
+    else if (const uint64_t dropped = MazeTrace::droppedEvents())
+      std::clog << "maze_trace.json: " << dropped << " oldest events were dropped" << std::endl;
+  }
+  {
+    static constexpr const char *playback_name[]{ "Diffs per frame", "Time budget", "Instant" };
+    int32_t mode = static_cast<int32_t>(playback_mode);
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::Combo("Playback", &mode, playback_name, IM_ARRAYSIZE(playback_name)))
+      playback_mode = static_cast<PlaybackMode>(mode);
+
+    ImGui::SetNextItemWidth(200.0f);
+    if (playback_mode == PlaybackMode::DIFFS_PER_FRAME)
+      ImGui::SliderInt("Speed (diffs/frame)", &diffs_per_frame, 1, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
+    else if (playback_mode == PlaybackMode::TIME_BUDGET)
+      ImGui::SliderFloat("Budget (ms/frame)", &frame_budget_ms, 0.1f, 16.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+  }
+  renderReplay();
+  renderJobs();
+  ImGui::BeginDisabled(replay_mode);
+  if (ImGui::Button("Save maze")) controller_ptr->saveMaze(MazeController::MAZE_PATH, MazeEncoding::BYTE);
+  ImGui::SameLine();
+  if (ImGui::Button("Save maze (bits)")) controller_ptr->saveMaze(MazeController::MAZE_PATH, MazeEncoding::BIT);
+  ImGui::SameLine();
+  if (ImGui::Button("Save maze (rle)")) controller_ptr->saveMaze(MazeController::MAZE_PATH, MazeEncoding::RLE);
+  ImGui::SameLine();
+  if (ImGui::Button("Load maze")) controller_ptr->loadMaze(MazeController::MAZE_PATH);
+  ImGui::SameLine();
+  if (ImGui::Button("Resume generation")) controller_ptr->resumeGeneration(MazeController::CHECKPOINT_PATH);
+  renderExport();
+  renderHeatmapControls();
   if (ImGui::Button("Generate Maze (Prim's)")) controller_ptr->handleInput(MazeAction::G_PRIMS);
   if (ImGui::Button("Generate Maze (Recursion Backtracker)")) controller_ptr->handleInput(MazeAction::G_RECURSION_BACKTRACKER);
   if (ImGui::Button("Generate Maze (Recursion Division)")) controller_ptr->handleInput(MazeAction::G_RECURSION_DIVISION);
+  if (ImGui::Button("Generate Maze (Growing Tree, newest)")) controller_ptr->handleInput(MazeAction::G_GROWING_TREE_NEWEST);
+  if (ImGui::Button("Generate Maze (Growing Tree, random)")) controller_ptr->handleInput(MazeAction::G_GROWING_TREE_RANDOM);
+  if (ImGui::Button("Generate Maze (Growing Tree, oldest)")) controller_ptr->handleInput(MazeAction::G_GROWING_TREE_OLDEST);
+  if (ImGui::Button("Generate Maze (Growing Tree, 75/25)")) controller_ptr->handleInput(MazeAction::G_GROWING_TREE_MIXED);
   if (ImGui::Button("Solve Maze (DFS)")) controller_ptr->handleInput(MazeAction::S_DFS);
   if (ImGui::Button("Solve Maze (BFS)")) controller_ptr->handleInput(MazeAction::S_BFS);
   if (ImGui::Button("Solve Maze (UCS Manhattan)")) controller_ptr->handleInput(MazeAction::S_UCS_MANHATTAN);
@@ -103,10 +866,12 @@ void MazeView::renderGUI()
   if (ImGui::Button("Solve Maze (Greedy)")) controller_ptr->handleInput(MazeAction::S_GREEDY);
   if (ImGui::Button("Solve Maze (A*)")) controller_ptr->handleInput(MazeAction::S_ASTAR);
   if (ImGui::Button("Solve Maze (A* Interval)")) controller_ptr->handleInput(MazeAction::S_ASTAR_INTERVAL);
+  ImGui::EndDisabled();
+  renderStats();
   ImGui::EndGroup();
 
   ImGui::SameLine();
-  ImGui::BeginChild("MazeView", ImVec2(0, 0), true);
+  ImGui::BeginChild("MazeView", ImVec2(0, 0), true, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
   // std::this_thread::sleep_for(std::chrono::nanoseconds(1));
   renderMaze();
   ImGui::EndChild();
@@ -118,24 +883,40 @@ void MazeView::render(GLFWwindow *window)
 {
   // render loop
   ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+  MazeTrace::setThreadName("UI");
   while (!glfwWindowShouldClose(window)) {
+    MAZE_TRACE_SCOPE("frame");
     glfwPollEvents();
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    renderGUI();
+    {
+      MAZE_TRACE_SCOPE("renderGUI");
+      renderGUI();
+    }
 
     // Rendering
-    ImGui::Render();
-    int display_w, display_h;
-    glfwGetFramebufferSize(window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      MAZE_TRACE_SCOPE("ImGui::Render");
+      ImGui::Render();
+    }
+    {
+      MAZE_TRACE_SCOPE("GL submit");
+      int display_w, display_h;
+      glfwGetFramebufferSize(window, &display_w, &display_h);
+      glViewport(0, 0, display_w, display_h);
+      glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+      glClear(GL_COLOR_BUFFER_BIT);
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
-    glfwSwapBuffers(window);
+    {
+      MAZE_TRACE_SCOPE("glfwSwapBuffers");
+      glfwSwapBuffers(window);
+    }
   }
+
+  releaseTexture();    // 離開 render loop 之後 GL context 很快就會被銷毀
 }
\ No newline at end of file
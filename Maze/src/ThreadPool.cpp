@@ -0,0 +1,225 @@
+#include "ThreadPool.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+  // 目前這條 thread 屬於哪個 pool 的第幾個 worker
+  thread_local const ThreadPool *current_pool = nullptr;
+  thread_local size_t current_index = 0;
+
+  bool pinThread(std::thread &thread, const size_t cpu)
+  {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    (void) thread;
+    (void) cpu;
+    return false;
+#endif
+  }
+}    // namespace
+
+ThreadPool::ThreadPool(const size_t worker_count, const bool pin_workers)
+    : queued{ 0 }, stopping{ false }, pinned{ pin_workers }
+{
+  const size_t cpu_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  const size_t count = worker_count == 0 ? cpu_count : worker_count;
+
+  // 先把所有 deque 建好，worker 一開始就可能去偷別人的
+  workers.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    workers.push_back(std::make_unique<Worker>());
+  for (size_t i = 0; i < count; ++i) {
+    workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+    if (pin_workers)
+      pinned = pinThread(workers[i]->thread, i % cpu_count) && pinned;
+  }
+}
+
+/**
+ * @brief finish every queued task, then stop the workers
+ */
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (const auto &worker : workers)
+    worker->thread.join();
+}
+
+bool ThreadPool::isWorkerThread() const
+{
+  return current_pool == this;
+}
+
+/**
+ * @brief queue a task, a worker pushes to its own deque and everyone else to the injection queue
+ */
+void ThreadPool::post(Task task)
+{
+  // 先加計數再放進 deque，queued 只會比實際的多不會少，worker 不會在還有工作的時候睡著
+  if (isWorkerThread()) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      queued.fetch_add(1);
+    }
+    Worker &self = *workers[current_index];
+    std::lock_guard<std::mutex> lock(self.mtx);
+    self.tasks.push_back(std::move(task));
+  }
+  else {
+    std::lock_guard<std::mutex> lock(mtx);
+    queued.fetch_add(1);
+    injection.push_back(std::move(task));
+  }
+  cv.notify_one();
+}
+
+/**
+ * @brief run body on [begin, end) split into chunks of grain, the calling thread works on chunks too
+ *
+ * Returns once every chunk is done. The first exception thrown by body is rethrown here. Once the caller runs out
+ * of chunks the rest are already running on other threads, so it only has to wait for them, never help.
+ */
+void ThreadPool::parallelFor(const size_t begin, const size_t end, const size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+  if (begin >= end)
+    return;
+
+  const size_t step = std::max<size_t>(grain, 1);
+  const size_t chunk_count = (end - begin + step - 1) / step;
+  if (chunk_count == 1) {
+    body(begin, end);
+    return;
+  }
+
+  // 晚開始的 helper 可能在這個函式回傳後才跑，所以狀態放在 shared_ptr 裡
+  struct ForState {
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> done{ 0 };
+    std::mutex error_mtx;
+    std::exception_ptr error;
+  };
+  auto state = std::make_shared<ForState>();
+  const std::function<void(size_t, size_t)> *body_ptr = &body;
+
+  auto run_chunks = [state, body_ptr, begin, end, step, chunk_count] {
+    size_t chunk;
+    while ((chunk = state->next.fetch_add(1)) < chunk_count) {
+      const size_t chunk_begin = begin + chunk * step;
+      try {
+        (*body_ptr)(chunk_begin, std::min(chunk_begin + step, end));
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(state->error_mtx);
+        if (!state->error)
+          state->error = std::current_exception();
+      }
+      state->done.fetch_add(1, std::memory_order_acq_rel);
+    }
+  };
+
+  const size_t helper_count = std::min(chunk_count - 1, workers.size());
+  for (size_t i = 0; i < helper_count; ++i)
+    post(run_chunks);
+  run_chunks();
+  while (state->done.load(std::memory_order_acquire) != chunk_count)
+    std::this_thread::yield();
+
+  if (state->error)
+    std::rethrow_exception(state->error);
+}
+
+/**
+ * @brief run one queued task on the calling thread
+ *
+ * @return false if there was nothing to run
+ */
+bool ThreadPool::runPending()
+{
+  Task task;
+  if (!popTask(isWorkerThread() ? current_index : workers.size(), task))
+    return false;
+  task();
+  return true;
+}
+
+/**
+ * @brief own deque from the back, then the injection queue, then steal from the front of the other workers
+ *
+ * @param self index of the calling worker, or size() for a thread outside the pool
+ */
+bool ThreadPool::popTask(const size_t self, Task &task)
+{
+  if (queued.load() == 0)
+    return false;
+
+  if (self < workers.size()) {
+    Worker &worker = *workers[self];
+    std::lock_guard<std::mutex> lock(worker.mtx);
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!injection.empty()) {
+      task = std::move(injection.front());
+      injection.pop_front();
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i <= workers.size(); ++i) {
+    const size_t victim = (self + i) % workers.size();
+    if (victim == self)
+      continue;
+    Worker &worker = *workers[victim];
+    std::lock_guard<std::mutex> lock(worker.mtx);
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(const size_t index)
+{
+  current_pool = this;
+  current_index = index;
+  MazeTrace::setThreadName(("worker " + std::to_string(index)).c_str());
+
+  while (true) {
+    Task task;
+    if (popTask(index, task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping && queued.load() == 0)
+      return;
+  }
+}
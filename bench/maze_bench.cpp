@@ -0,0 +1,200 @@
+/**
+ * @file maze_bench.cpp
+ * @author Mes (mes900903@gmail.com)
+ * @brief Benchmark every generator and solver of the maze over a ladder of maze sizes
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * usage: maze_bench [--sizes 39x75,199x399] [--warmup N] [--reps N] [--seed S] [--max-cells N] [--json file] [--csv file] [--trace file]
+ *
+ * Every run uses a fixed seed (seed + repetition index), so the numbers of two builds are comparable.
+ * Solvers run on a Prim's maze generated with the base seed.
+ */
+
+#include "MazeModel.h"
+#include "MazeAction.h"
+#include "MazeStats.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  struct BenchConfig {
+    std::vector<std::pair<int32_t, int32_t>> sizes{ { 39, 75 }, { 199, 399 }, { 999, 1999 }, { 4999, 4999 }, { 20000, 20000 } };
+    int32_t warmup = 1;
+    int32_t reps = 5;
+    uint32_t seed = 12345;
+    uint64_t max_cells = 0;    // 0 代表不限制
+    std::string json_path;
+    std::string csv_path;
+    std::string trace_path;    // 有設定就把 Chrome trace 寫到這個檔案
+  };
+
+  struct BenchResult {
+    int32_t height, width;
+    MazeAction action;
+    int32_t reps;
+    double median_ms, p95_ms, min_ms;
+    double cells_per_second;
+    MazeStats last;    // 最後一次執行的計數器
+  };
+
+  /**
+   * @brief nearest-rank percentile of sorted samples
+   */
+  double percentile(const std::vector<double> &sorted, const double p)
+  {
+    if (sorted.empty()) return 0.0;
+    const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+  std::vector<std::pair<int32_t, int32_t>> parseSizes(const std::string &text)
+  {
+    std::vector<std::pair<int32_t, int32_t>> sizes;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      const size_t x_pos = item.find('x');
+      if (x_pos == std::string::npos) {
+        std::clog << "invalid size " << item << ", expected HEIGHTxWIDTH" << std::endl;
+        continue;
+      }
+      sizes.emplace_back(std::atoi(item.substr(0, x_pos).c_str()), std::atoi(item.substr(x_pos + 1).c_str()));
+    }
+    return sizes;
+  }
+
+  bool parseArgs(int argc, char **argv, BenchConfig &config)
+  {
+    for (int i = 1; i < argc; ++i) {
+      const bool has_value = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--sizes") && has_value) config.sizes = parseSizes(argv[++i]);
+      else if (!std::strcmp(argv[i], "--warmup") && has_value) config.warmup = std::atoi(argv[++i]);
+      else if (!std::strcmp(argv[i], "--reps") && has_value) config.reps = std::max(1, std::atoi(argv[++i]));
+      else if (!std::strcmp(argv[i], "--seed") && has_value) config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      else if (!std::strcmp(argv[i], "--max-cells") && has_value) config.max_cells = std::strtoull(argv[++i], nullptr, 10);
+      else if (!std::strcmp(argv[i], "--json") && has_value) config.json_path = argv[++i];
+      else if (!std::strcmp(argv[i], "--csv") && has_value) config.csv_path = argv[++i];
+      else if (!std::strcmp(argv[i], "--trace") && has_value) config.trace_path = argv[++i];
+      else {
+        std::clog << "usage: " << argv[0] << " [--sizes 39x75,199x399] [--warmup N] [--reps N] [--seed S] [--max-cells N] [--json file] [--csv file] [--trace file]" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool isGenerator(const MazeAction action)
+  {
+    return action != MazeAction::G_RESET && action < MazeAction::S_DFS;
+  }
+
+  BenchResult runBench(MazeModel &model, const MazeAction action, const BenchConfig &config)
+  {
+    std::vector<double> samples;
+    MazeStats stats;
+    for (int32_t rep = -config.warmup; rep < config.reps; ++rep) {
+      if (isGenerator(action)) {
+        model.setSeed(config.seed + static_cast<uint32_t>(std::max(rep, 0)));
+        model.resetMaze();
+      }
+
+      stats = model.runAction(action);
+      if (rep >= 0)
+        samples.push_back(stats.elapsed_ms);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult result{ model.height, model.width, action, config.reps, percentile(samples, 0.5), percentile(samples, 0.95), samples.front(), 0.0, stats };
+    const double cells = static_cast<double>(model.height) * model.width;
+    result.cells_per_second = result.median_ms > 0.0 ? cells / (result.median_ms / 1000.0) : 0.0;
+    return result;
+  }
+
+  void writeJson(std::ostream &os, const BenchConfig &config, const std::vector<BenchResult> &results)
+  {
+    os << "{\n  \"seed\": " << config.seed << ",\n  \"warmup\": " << config.warmup << ",\n  \"reps\": " << config.reps << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchResult &r = results[i];
+      os << "    { \"height\": " << r.height << ", \"width\": " << r.width
+         << ", \"algorithm\": \"" << maze_action_name[static_cast<int32_t>(r.action)] << "\""
+         << ", \"median_ms\": " << r.median_ms << ", \"p95_ms\": " << r.p95_ms << ", \"min_ms\": " << r.min_ms
+         << ", \"cells_per_second\": " << r.cells_per_second
+         << ", \"nodes_expanded\": " << r.last.nodes_expanded << ", \"pushes\": " << r.last.pushes << ", \"pops\": " << r.last.pops
+         << ", \"peak_open\": " << r.last.peak_open << ", \"peak_memory\": " << r.last.peak_memory
+         << ", \"path_length\": " << r.last.path_length << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+  }
+
+  void writeCsv(std::ostream &os, const std::vector<BenchResult> &results)
+  {
+    os << "height,width,algorithm,reps,median_ms,p95_ms,min_ms,cells_per_second,nodes_expanded,pushes,pops,peak_open,peak_memory,path_length\n";
+    for (const BenchResult &r : results) {
+      os << r.height << ',' << r.width << ',' << maze_action_name[static_cast<int32_t>(r.action)] << ',' << r.reps << ','
+         << r.median_ms << ',' << r.p95_ms << ',' << r.min_ms << ',' << r.cells_per_second << ','
+         << r.last.nodes_expanded << ',' << r.last.pushes << ',' << r.last.pops << ','
+         << r.last.peak_open << ',' << r.last.peak_memory << ',' << r.last.path_length << '\n';
+    }
+  }
+}    // namespace
+
+int main(int argc, char **argv)
+{
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config))
+    return 1;
+
+  MazeTrace::setEnabled(!config.trace_path.empty());
+
+  std::vector<BenchResult> results;
+  for (auto [height, width] : config.sizes) {
+    // 生成演算法都是在奇數座標上挖路，偶數的邊長會讓終點被牆圍住
+    height -= (height % 2 == 0);
+    width -= (width % 2 == 0);
+    if (height < 5 || width < 5) continue;
+    if (config.max_cells && static_cast<uint64_t>(height) * width > config.max_cells) {
+      std::clog << "skip " << height << 'x' << width << " (--max-cells " << config.max_cells << ")" << std::endl;
+      continue;
+    }
+
+    auto model = std::make_unique<MazeModel>(height, width);
+    for (int32_t i = 1; i < MAZE_ACTION_COUNT; ++i) {
+      const MazeAction action = static_cast<MazeAction>(i);
+      if (action == MazeAction::S_DFS) {    // 第一個解法，之後所有解法都跑同一張 Prim's 迷宮
+        model->setSeed(config.seed);
+        model->resetMaze();
+        model->generateMazePrim();
+      }
+
+      const BenchResult result = runBench(*model, action, config);
+      std::cout << height << 'x' << width << '\t' << maze_action_name[i]
+                << "\tmedian " << result.median_ms << " ms\tp95 " << result.p95_ms << " ms\t"
+                << result.cells_per_second << " cells/s" << std::endl;
+      results.push_back(result);
+    }
+  }
+
+  if (!config.json_path.empty()) {
+    std::ofstream json(config.json_path);
+    writeJson(json, config, results);
+  }
+  if (!config.csv_path.empty()) {
+    std::ofstream csv(config.csv_path);
+    writeCsv(csv, results);
+  }
+  if (!config.trace_path.empty() && !MazeTrace::save(config.trace_path))
+    std::clog << "failed to write " << config.trace_path << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file queue_bench.cpp
+ * @author Mes (mes900903@gmail.com)
+ * @brief Throughput of the model-to-view diff channel: mutex ThreadSafeQueue, lock-free SpscRingBuffer of single diffs, and of MazeDiffBatch chunks
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * usage: queue_bench [--count N] [--capacity N] [--batch N] [--reps N]
+ *
+ * One producer thread pushes MazeNode diffs while the main thread pops them, the same shape as a generator
+ * thread feeding the UI thread.
+ */
+
+#include "MazeNode.h"
+#include "MazeDiffBatch.h"
+#include "SpscRingBuffer.h"
+#include "ThreadSafeQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+  struct QueueBenchConfig {
+    uint64_t count = 10'000'000;
+    size_t capacity = size_t{ 1 } << 16;
+    size_t batch = 64;
+    int32_t reps = 3;
+  };
+
+  MazeNode makeNode(const uint64_t i)
+  {
+    return MazeNode{ static_cast<int32_t>(i >> 16), static_cast<int32_t>(i & 0xffff), MazeElement::GROUND };
+  }
+
+  /**
+   * @brief run producer against consumer once and return the elapsed milliseconds
+   *
+   * The consumer sums the coordinates it pops and compares them to the expected sum, so a lost or
+   * duplicated diff shows up as an error instead of a fast number.
+   */
+  template <typename Produce, typename Consume>
+  double timeRun(const uint64_t count, Produce produce, Consume consume)
+  {
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+      const MazeNode node = makeNode(i);
+      expected += static_cast<uint64_t>(node.y) + static_cast<uint64_t>(node.x);
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::thread producer(produce);
+    uint64_t sum = 0, received = 0;
+    while (received < count) {
+      const uint64_t got = consume(sum);
+      if (got == 0)
+        std::this_thread::yield();
+      received += got;
+    }
+    producer.join();
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (sum != expected)
+      std::clog << "checksum mismatch: " << sum << " != " << expected << std::endl;
+    return elapsed_ms;
+  }
+
+  double benchMutexQueue(const QueueBenchConfig &config)
+  {
+    ThreadSafeQueue<MazeNode> queue;
+    return timeRun(
+        config.count,
+        [&] {
+          for (uint64_t i = 0; i < config.count; ++i)
+            queue.enqueue(makeNode(i));
+        },
+        [&](uint64_t &sum) -> uint64_t {
+          std::optional<MazeNode> node = queue.dequeue();
+          if (!node.has_value()) return 0;
+          sum += static_cast<uint64_t>(node->y) + static_cast<uint64_t>(node->x);
+          return 1;
+        });
+  }
+
+  double benchRingSingle(const QueueBenchConfig &config)
+  {
+    SpscRingBuffer<MazeNode> ring(config.capacity);
+    return timeRun(
+        config.count,
+        [&] {
+          for (uint64_t i = 0; i < config.count; ++i)
+            ring.push(makeNode(i));
+        },
+        [&](uint64_t &sum) -> uint64_t {
+          std::optional<MazeNode> node = ring.tryPop();
+          if (!node.has_value()) return 0;
+          sum += static_cast<uint64_t>(node->y) + static_cast<uint64_t>(node->x);
+          return 1;
+        });
+  }
+
+  double benchRingBatch(const QueueBenchConfig &config)
+  {
+    SpscRingBuffer<MazeNode> ring(config.capacity);
+    std::vector<MazeNode> out(config.batch);
+    return timeRun(
+        config.count,
+        [&] {
+          std::vector<MazeNode> in(config.batch);
+          for (uint64_t i = 0; i < config.count;) {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(config.batch, config.count - i));
+            for (size_t j = 0; j < n; ++j)
+              in[j] = makeNode(i + j);
+            ring.pushBatch(in.data(), n);
+            i += n;
+          }
+        },
+        [&](uint64_t &sum) -> uint64_t {
+          const size_t n = ring.popBatch(out.data(), out.size());
+          for (size_t j = 0; j < n; ++j)
+            sum += static_cast<uint64_t>(out[j].y) + static_cast<uint64_t>(out[j].x);
+          return n;
+        });
+  }
+
+  // 和 model 一樣：在本地填滿一整批，再一次推進 ring
+  double benchDiffBatch(const QueueBenchConfig &config)
+  {
+    SpscRingBuffer<MazeDiffBatch> ring(std::max<size_t>(config.capacity / MazeDiffBatch::CELL_CAPACITY, 2));
+    return timeRun(
+        config.count,
+        [&] {
+          auto batch = std::make_unique<MazeDiffBatch>();
+          for (uint64_t i = 0; i < config.count; ++i) {
+            const MazeNode node = makeNode(i);
+            if (!batch->pushCell(static_cast<uint32_t>(node.y) << 16 | static_cast<uint32_t>(node.x), node.element)) {
+              ring.push(*batch);
+              batch->clear();
+              batch->pushCell(static_cast<uint32_t>(node.y) << 16 | static_cast<uint32_t>(node.x), node.element);
+            }
+          }
+          if (!batch->empty()) ring.push(*batch);
+        },
+        [&](uint64_t &sum) -> uint64_t {
+          std::optional<MazeDiffBatch> batch = ring.tryPop();
+          if (!batch.has_value()) return 0;
+          for (uint32_t j = 0; j < batch->cell_count; ++j)
+            sum += (batch->cell_index[j] >> 16) + (batch->cell_index[j] & 0xffff);
+          return batch->cell_count;
+        });
+  }
+
+  bool parseArgs(int argc, char **argv, QueueBenchConfig &config)
+  {
+    for (int i = 1; i < argc; ++i) {
+      const bool has_value = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--count") && has_value) config.count = std::strtoull(argv[++i], nullptr, 10);
+      else if (!std::strcmp(argv[i], "--capacity") && has_value) config.capacity = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+      else if (!std::strcmp(argv[i], "--batch") && has_value) config.batch = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+      else if (!std::strcmp(argv[i], "--reps") && has_value) config.reps = std::max(1, std::atoi(argv[++i]));
+      else {
+        std::clog << "usage: " << argv[0] << " [--count N] [--capacity N] [--batch N] [--reps N]" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}    // namespace
+
+int main(int argc, char **argv)
+{
+  QueueBenchConfig config;
+  if (!parseArgs(argc, argv, config))
+    return 1;
+
+  struct Case {
+    const char *name;
+    double (*run)(const QueueBenchConfig &);
+  };
+  const Case cases[]{ { "ThreadSafeQueue", benchMutexQueue }, { "SpscRingBuffer", benchRingSingle }, { "SpscRingBuffer batch", benchRingBatch }, { "MazeDiffBatch", benchDiffBatch } };
+
+  for (const Case &c : cases) {
+    double best_ms = 0.0;
+    for (int32_t rep = 0; rep < config.reps; ++rep) {
+      const double elapsed_ms = c.run(config);
+      best_ms = rep == 0 ? elapsed_ms : std::min(best_ms, elapsed_ms);
+    }
+    std::cout << c.name << "\tbest " << best_ms << " ms\t" << config.count / (best_ms / 1000.0) << " diffs/s" << std::endl;
+  }
+
+  return 0;
+}
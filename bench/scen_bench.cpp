@@ -0,0 +1,299 @@
+/**
+ * @file scen_bench.cpp
+ * @author Mes (mes900903@gmail.com)
+ * @brief Run every query of Moving AI scenario files with every solver
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * usage: scen_bench [--map-dir DIR] [--reps N] [--limit N] [--json file] [--csv file] [--trace file] file.scen...
+ *
+ * The map of a scenario is looked up as written in the .scen file under --map-dir and next to the .scen file, with and
+ * without its directories. Every solver reports expansions, path length and the latency of each query; the summary
+ * gives the latency percentiles over the queries and the optimality gap against BFS, which is optimal for our
+ * 4-connected moves. The published octile optimum is reported next to it as the ratio path length / optimal length,
+ * 4-connected paths are longer than octile ones by up to sqrt(2) even when they are optimal.
+ */
+
+#include "MazeModel.h"
+#include "MazeAction.h"
+#include "MazeStats.h"
+#include "MazeTrace.h"
+#include "MazeMovingAI.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  struct BenchConfig {
+    std::vector<std::string> scen_paths;
+    std::string map_dir;
+    int32_t reps = 1;
+    size_t limit = 0;    // 每個 .scen 最多跑幾個 query，0 代表全部
+    std::string json_path;
+    std::string csv_path;    // 每個 query 一列
+    std::string trace_path;
+  };
+
+  struct QueryResult {
+    size_t query;    // 全部 .scen 一起算的編號
+    int32_t bucket;
+    MazeAction action;
+    uint64_t nodes_expanded;
+    uint64_t path_length;
+    uint64_t reference_length;    // 同一個 query BFS 的長度
+    double optimal_length;    // .scen 的 octile 最佳解
+    double ms;
+  };
+
+  struct SolverSummary {
+    MazeAction action;
+    size_t queries = 0, solved = 0, optimal = 0;
+    double mean_expanded = 0.0;
+    double mean_gap = 0.0, max_gap = 0.0;    // (長度 - BFS 長度) / BFS 長度
+    double mean_octile_ratio = 0.0;    // 長度 / octile 最佳解
+    double p50_ms = 0.0, p95_ms = 0.0, p99_ms = 0.0, total_ms = 0.0;
+  };
+
+  /**
+   * @brief nearest-rank percentile of sorted samples
+   */
+  double percentile(const std::vector<double> &sorted, const double p)
+  {
+    if (sorted.empty()) return 0.0;
+    const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+  bool parseArgs(int argc, char **argv, BenchConfig &config)
+  {
+    for (int i = 1; i < argc; ++i) {
+      const bool has_value = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--map-dir") && has_value) config.map_dir = argv[++i];
+      else if (!std::strcmp(argv[i], "--reps") && has_value) config.reps = std::max(1, std::atoi(argv[++i]));
+      else if (!std::strcmp(argv[i], "--limit") && has_value) config.limit = std::strtoull(argv[++i], nullptr, 10);
+      else if (!std::strcmp(argv[i], "--json") && has_value) config.json_path = argv[++i];
+      else if (!std::strcmp(argv[i], "--csv") && has_value) config.csv_path = argv[++i];
+      else if (!std::strcmp(argv[i], "--trace") && has_value) config.trace_path = argv[++i];
+      else if (argv[i][0] != '-') config.scen_paths.emplace_back(argv[i]);
+      else {
+        config.scen_paths.clear();
+        break;
+      }
+    }
+
+    if (config.scen_paths.empty()) {
+      std::clog << "usage: " << argv[0] << " [--map-dir DIR] [--reps N] [--limit N] [--json file] [--csv file] [--trace file] file.scen..." << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool isSolver(const MazeAction action)
+  {
+    return action >= MazeAction::S_DFS;
+  }
+
+  std::string directoryOf(const std::string &path)
+  {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string{} : path.substr(0, slash + 1);
+  }
+
+  std::string fileNameOf(const std::string &path)
+  {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+  }
+
+  /**
+   * @brief load the map a scenario refers to, trying --map-dir first and then the directory of the .scen file
+   */
+  bool loadScenarioMap(const BenchConfig &config, const std::string &scen_path, const std::string &map, MazeGrid &grid)
+  {
+    std::vector<std::string> candidates;
+    for (const std::string &dir : { config.map_dir.empty() ? std::string{} : config.map_dir + '/', directoryOf(scen_path) }) {
+      candidates.push_back(dir + map);
+      candidates.push_back(dir + fileNameOf(map));
+    }
+    for (const std::string &candidate : candidates)
+      if (MazeMovingAI::loadMap(candidate, grid))
+        return true;
+    return false;
+  }
+
+  bool isValidQuery(const MazeGrid &grid, const MazeScenario &scenario)
+  {
+    const auto passable = [&](const int32_t y, const int32_t x) {
+      return y >= 0 && y < grid.height() && x >= 0 && x < grid.width() && grid[y][x] != MazeElement::WALL;
+    };
+    return passable(scenario.start_y, scenario.start_x) && passable(scenario.goal_y, scenario.goal_x);
+  }
+
+  /**
+   * @brief run one query with every solver, the latency of a query is the median of its repetitions
+   */
+  void runQuery(MazeModel &model, const MazeScenario &scenario, const size_t query, const BenchConfig &config, std::vector<QueryResult> &results)
+  {
+    model.setEndpoints(scenario.start_y, scenario.start_x, scenario.goal_y, scenario.goal_x);
+    const size_t first = results.size();
+    std::vector<double> samples;
+    for (int32_t i = 0; i < MAZE_ACTION_COUNT; ++i) {
+      const MazeAction action = static_cast<MazeAction>(i);
+      if (!isSolver(action))
+        continue;
+
+      MazeStats stats;
+      samples.clear();
+      for (int32_t rep = 0; rep < config.reps; ++rep) {
+        stats = model.runAction(action);
+        samples.push_back(stats.elapsed_ms);
+      }
+      std::sort(samples.begin(), samples.end());
+      results.push_back(QueryResult{ query, scenario.bucket, action, stats.nodes_expanded, stats.path_length, 0, scenario.optimal_length, percentile(samples, 0.5) });
+    }
+
+    const auto bfs = std::find_if(results.begin() + first, results.end(), [](const QueryResult &r) { return r.action == MazeAction::S_BFS; });
+    for (auto it = results.begin() + first; it != results.end(); ++it)
+      it->reference_length = bfs->path_length;
+  }
+
+  SolverSummary summarize(const MazeAction action, const std::vector<QueryResult> &results)
+  {
+    SolverSummary summary;
+    summary.action = action;
+    std::vector<double> latencies;
+    for (const QueryResult &r : results) {
+      if (r.action != action)
+        continue;
+
+      ++summary.queries;
+      latencies.push_back(r.ms);
+      summary.total_ms += r.ms;
+      summary.mean_expanded += static_cast<double>(r.nodes_expanded);
+      if (!r.path_length || !r.reference_length)
+        continue;
+
+      ++summary.solved;
+      const double gap = (static_cast<double>(r.path_length) - static_cast<double>(r.reference_length)) / static_cast<double>(r.reference_length);
+      summary.optimal += r.path_length == r.reference_length;
+      summary.mean_gap += gap;
+      summary.max_gap = std::max(summary.max_gap, gap);
+      if (r.optimal_length > 0.0)
+        summary.mean_octile_ratio += static_cast<double>(r.path_length) / r.optimal_length;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    summary.p50_ms = percentile(latencies, 0.5);
+    summary.p95_ms = percentile(latencies, 0.95);
+    summary.p99_ms = percentile(latencies, 0.99);
+    if (summary.queries)
+      summary.mean_expanded /= static_cast<double>(summary.queries);
+    if (summary.solved) {
+      summary.mean_gap /= static_cast<double>(summary.solved);
+      summary.mean_octile_ratio /= static_cast<double>(summary.solved);
+    }
+    return summary;
+  }
+
+  void writeJson(std::ostream &os, const BenchConfig &config, const size_t queries, const std::vector<SolverSummary> &summaries)
+  {
+    os << "{\n  \"reps\": " << config.reps << ",\n  \"queries\": " << queries << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < summaries.size(); ++i) {
+      const SolverSummary &s = summaries[i];
+      os << "    { \"algorithm\": \"" << maze_action_name[static_cast<int32_t>(s.action)] << "\""
+         << ", \"queries\": " << s.queries << ", \"solved\": " << s.solved << ", \"optimal\": " << s.optimal
+         << ", \"mean_expanded\": " << s.mean_expanded << ", \"mean_gap\": " << s.mean_gap << ", \"max_gap\": " << s.max_gap
+         << ", \"mean_octile_ratio\": " << s.mean_octile_ratio
+         << ", \"p50_ms\": " << s.p50_ms << ", \"p95_ms\": " << s.p95_ms << ", \"p99_ms\": " << s.p99_ms << ", \"total_ms\": " << s.total_ms
+         << " }" << (i + 1 < summaries.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+  }
+
+  void writeCsv(std::ostream &os, const std::vector<QueryResult> &results)
+  {
+    os << "query,bucket,algorithm,nodes_expanded,path_length,bfs_length,optimal_length,ms\n";
+    for (const QueryResult &r : results) {
+      os << r.query << ',' << r.bucket << ',' << maze_action_name[static_cast<int32_t>(r.action)] << ','
+         << r.nodes_expanded << ',' << r.path_length << ',' << r.reference_length << ',' << r.optimal_length << ',' << r.ms << '\n';
+    }
+  }
+}    // namespace
+
+int main(int argc, char **argv)
+{
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config))
+    return 1;
+
+  MazeTrace::setEnabled(!config.trace_path.empty());
+
+  auto model = std::make_unique<MazeModel>(MAZE_HEIGHT, MAZE_WIDTH);
+  std::vector<QueryResult> results;
+  std::string loaded_map;    // 連續的 query 通常是同一張地圖
+  size_t queries = 0, skipped = 0;
+  for (const std::string &scen_path : config.scen_paths) {
+    std::vector<MazeScenario> scenarios;
+    if (!MazeMovingAI::loadScenarios(scen_path, scenarios)) {
+      std::clog << "failed to read " << scen_path << std::endl;
+      continue;
+    }
+    if (config.limit && scenarios.size() > config.limit)
+      scenarios.resize(config.limit);
+
+    for (const MazeScenario &scenario : scenarios) {
+      if (scenario.map != loaded_map) {
+        MazeGrid grid;
+        if (!loadScenarioMap(config, scen_path, scenario.map, grid) || !model->setMaze(std::move(grid))) {
+          std::clog << "failed to load map " << scenario.map << " of " << scen_path << std::endl;
+          ++skipped;
+          continue;
+        }
+        loaded_map = scenario.map;
+      }
+
+      // 起點等於終點的 query 解法不會回報路徑，也沒有 gap 可以算
+      const bool trivial = scenario.start_y == scenario.goal_y && scenario.start_x == scenario.goal_x;
+      if (trivial || scenario.map_height != model->height || scenario.map_width != model->width || !isValidQuery(model->maze, scenario)) {
+        ++skipped;
+        continue;
+      }
+      runQuery(*model, scenario, queries++, config, results);
+    }
+    std::cout << scen_path << '\t' << queries << " queries so far" << std::endl;
+  }
+  if (skipped)
+    std::clog << "skipped " << skipped << " queries (map missing, start equals goal, or endpoint blocked)" << std::endl;
+
+  std::vector<SolverSummary> summaries;
+  for (int32_t i = 0; i < MAZE_ACTION_COUNT; ++i) {
+    if (!isSolver(static_cast<MazeAction>(i)))
+      continue;
+
+    const SolverSummary s = summarize(static_cast<MazeAction>(i), results);
+    std::cout << maze_action_name[i] << "\texpanded " << s.mean_expanded << "\toptimal " << s.optimal << '/' << s.solved
+              << "\tgap mean " << s.mean_gap * 100.0 << "% max " << s.max_gap * 100.0 << "%\tvs octile " << s.mean_octile_ratio
+              << "\tp50 " << s.p50_ms << " ms\tp95 " << s.p95_ms << " ms\tp99 " << s.p99_ms << " ms" << std::endl;
+    summaries.push_back(s);
+  }
+
+  if (!config.json_path.empty()) {
+    std::ofstream json(config.json_path);
+    writeJson(json, config, queries, summaries);
+  }
+  if (!config.csv_path.empty()) {
+    std::ofstream csv(config.csv_path);
+    writeCsv(csv, results);
+  }
+  if (!config.trace_path.empty() && !MazeTrace::save(config.trace_path))
+    std::clog << "failed to write " << config.trace_path << std::endl;
+
+  return 0;
+}
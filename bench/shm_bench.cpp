@@ -0,0 +1,118 @@
+/**
+ * @file shm_bench.cpp
+ * @author Mes (mes900903@gmail.com)
+ * @brief Snapshot throughput and consistency of the shared-memory grid while a writer keeps publishing
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * usage: shm_bench [--size 4001x4001] [--seconds S] [--writer-sleep-us N] [--name /maze_shm_bench]
+ *
+ * The writer fills the whole grid with one byte per publish (a different one every time), the reader maps the segment
+ * by name like an external process would and checks that every snapshot holds a single byte. It reports publishes/s,
+ * snapshots/s, the copy bandwidth, retries per snapshot and the number of torn snapshots, which has to be 0.
+ */
+
+#include "MazeGrid.h"
+#include "MazeSharedGrid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+  struct BenchConfig {
+    int32_t height = 4001, width = 4001;
+    double seconds = 3.0;
+    uint32_t writer_sleep_us = 0;    // 0 代表 writer 一直寫，最差的情況
+    std::string name = "/maze_shm_bench";
+  };
+
+  bool parseArgs(int argc, char **argv, BenchConfig &config)
+  {
+    for (int i = 1; i < argc; ++i) {
+      const bool has_value = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--size") && has_value) {
+        const std::string size = argv[++i];
+        const size_t x_pos = size.find('x');
+        config.height = std::atoi(size.substr(0, x_pos).c_str());
+        config.width = x_pos == std::string::npos ? config.height : std::atoi(size.substr(x_pos + 1).c_str());
+      }
+      else if (!std::strcmp(argv[i], "--seconds") && has_value) config.seconds = std::atof(argv[++i]);
+      else if (!std::strcmp(argv[i], "--writer-sleep-us") && has_value) config.writer_sleep_us = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      else if (!std::strcmp(argv[i], "--name") && has_value) config.name = argv[++i];
+      else {
+        std::clog << "usage: " << argv[0] << " [--size 4001x4001] [--seconds S] [--writer-sleep-us N] [--name /maze_shm_bench]" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}    // namespace
+
+int main(int argc, char **argv)
+{
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config))
+    return 1;
+
+  MazeSharedGrid writer;
+  if (!writer.create(config.name, config.height, config.width)) {
+    std::clog << "failed to create shared memory " << config.name << std::endl;
+    return 1;
+  }
+
+  std::atomic<bool> stop{ false };
+  uint64_t publishes = 0;
+  std::thread writer_thread([&] {
+    MazeGrid grid(config.height, config.width);
+    while (!stop.load(std::memory_order_relaxed)) {
+      std::fill_n(grid.data(), grid.size(), static_cast<MazeElement>(publishes & 0x7F));
+      writer.publish(grid);
+      ++publishes;
+      if (config.writer_sleep_us)
+        std::this_thread::sleep_for(std::chrono::microseconds(config.writer_sleep_us));
+      else
+        std::this_thread::yield();    // 單核心的機器上也要讓 reader 有機會跑
+    }
+  });
+
+  MazeSharedGrid reader;
+  if (!reader.open(config.name)) {
+    stop.store(true);
+    writer_thread.join();
+    std::clog << "failed to open shared memory " << config.name << std::endl;
+    return 1;
+  }
+
+  MazeGrid snapshot;
+  uint64_t snapshots = 0, failed = 0, torn = 0, last_version = 0;
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(config.seconds));
+  while (std::chrono::steady_clock::now() < deadline) {
+    uint64_t version;
+    if (!reader.snapshot(snapshot, version)) {
+      ++failed;
+      continue;
+    }
+    ++snapshots;
+    const MazeElement first = snapshot.data()[0];
+    if (std::any_of(snapshot.data(), snapshot.data() + snapshot.size(), [first](const MazeElement cell) { return cell != first; }) || version < last_version)
+      ++torn;
+    last_version = version;
+  }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stop.store(true);
+  writer_thread.join();
+
+  const double mib = static_cast<double>(snapshot.size()) * snapshots / (1 << 20);
+  std::cout << config.height << 'x' << config.width << ", " << publishes / elapsed << " publishes/s, " << snapshots / elapsed << " snapshots/s ("
+            << mib / elapsed << " MiB/s), " << (snapshots ? static_cast<double>(reader.retries()) / snapshots : 0.0) << " retries/snapshot, "
+            << failed << " failed, " << torn << " torn" << std::endl;
+  return torn == 0 ? 0 : 1;
+}
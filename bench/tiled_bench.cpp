@@ -0,0 +1,103 @@
+/**
+ * @file tiled_bench.cpp
+ * @author Mes (mes900903@gmail.com)
+ * @brief Generate and solve a maze stored in a tiled file under a resident memory limit
+ * @version 0.1
+ * @date 2024-09-22
+ *
+ * usage: tiled_bench [--size 20001x20001] [--resident-mb N] [--tile-shift S] [--seed S] [--dir DIR] [--keep]
+ *
+ * Every generator is followed by BFS and A* on the maze it made, each run reports its time and the tile faults /
+ * evictions of the maze file and the scratch file. --keep leaves the maze file (DIR/tiled_maze.mztl) behind.
+ */
+
+#include "MazeOutOfCore.h"
+#include "MazeStats.h"
+#include "MazeTiledGrid.h"
+#include "MazeTrace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+  struct BenchConfig {
+    int32_t height = 20001, width = 20001;
+    size_t resident_mb = 64;    // 迷宮檔和 scratch 檔各自的上限
+    uint32_t tile_shift = MazeTiledGrid::DEFAULT_TILE_SHIFT;
+    uint32_t seed = 12345;
+    std::string dir = ".";
+    bool keep = false;
+  };
+
+  bool parseArgs(int argc, char **argv, BenchConfig &config)
+  {
+    for (int i = 1; i < argc; ++i) {
+      const bool has_value = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--size") && has_value) {
+        const std::string size = argv[++i];
+        const size_t x_pos = size.find('x');
+        config.height = std::atoi(size.substr(0, x_pos).c_str());
+        config.width = x_pos == std::string::npos ? config.height : std::atoi(size.substr(x_pos + 1).c_str());
+      }
+      else if (!std::strcmp(argv[i], "--resident-mb") && has_value) config.resident_mb = std::strtoull(argv[++i], nullptr, 10);
+      else if (!std::strcmp(argv[i], "--tile-shift") && has_value) config.tile_shift = static_cast<uint32_t>(std::atoi(argv[++i]));
+      else if (!std::strcmp(argv[i], "--seed") && has_value) config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      else if (!std::strcmp(argv[i], "--dir") && has_value) config.dir = argv[++i];
+      else if (!std::strcmp(argv[i], "--keep")) config.keep = true;
+      else {
+        std::clog << "usage: " << argv[0] << " [--size 20001x20001] [--resident-mb N] [--tile-shift S] [--seed S] [--dir DIR] [--keep]" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void report(const char *name, const MazeStats &stats, const MazeTileStats &grid, const MazeTileStats &scratch)
+  {
+    std::cout << name << '\t' << stats.elapsed_ms << " ms\texpanded " << stats.nodes_expanded << "\tpath " << stats.path_length
+              << "\tpeak open " << stats.peak_open << "\tfaults " << grid.faults << " (+" << scratch.faults << " scratch)"
+              << "\tevictions " << grid.evictions << " (+" << scratch.evictions << " scratch)" << std::endl;
+  }
+}    // namespace
+
+int main(int argc, char **argv)
+{
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config))
+    return 1;
+
+  const size_t resident_bytes = config.resident_mb << 20;
+  const std::string maze_path = config.dir + "/tiled_maze.mztl";
+  MazeTiledGrid grid;
+  if (!grid.create(maze_path, config.height, config.width, resident_bytes, config.tile_shift)) {
+    std::clog << "failed to create " << maze_path << std::endl;
+    return 1;
+  }
+  std::cout << config.height << 'x' << config.width << ", " << (grid.stats().tile_bytes >> 10) << " KiB tiles, "
+            << (grid.residentLimit() >> 20) << " MiB resident per file" << std::endl;
+
+  MazeOutOfCore maze(grid, config.dir + "/tiled_maze.scratch", resident_bytes);
+  for (const bool eller : { false, true }) {
+    grid.resetStats();
+    const MazeStats generated = eller ? maze.generateEller(config.seed) : maze.generateBacktracker(config.seed);
+    report(eller ? "Eller" : "Backtracker", generated, grid.stats(), maze.scratchStats());
+
+    grid.resetStats();
+    const MazeStats bfs = maze.solveBFS();
+    report("  BFS", bfs, grid.stats(), maze.scratchStats());
+
+    grid.resetStats();
+    const MazeStats astar = maze.solveAStar();
+    report("  A*", astar, grid.stats(), maze.scratchStats());
+  }
+
+  grid.close();
+  if (!config.keep)
+    std::remove(maze_path.c_str());
+  return 0;
+}
@@ -20,6 +20,8 @@
 #endif
 
 #include <stdexcept>
+#include <cstdlib>
+#include <cstring>
 
 #include "MazeModel.h"
 #include "MazeView.h"
@@ -30,8 +32,26 @@ static void glfw_error_callback(int error, const char *description)
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main(int, char **)
+int main(int argc, char **argv)
 {
+  // --workers N 設定 thread pool 的大小，--pin 把每個 worker 綁在自己的 CPU 上
+  // --checkpoint-every S 生成迷宮時每 S 秒存一次 checkpoint，可以用 Resume generation 接著跑
+  // --shm NAME 把畫面上的迷宮放在 POSIX shared memory NAME (例如 /maze_grid)，其他程式可以直接讀
+  size_t worker_count = 0;
+  bool pin_workers = false;
+  double checkpoint_seconds = -1.0;
+  const char *shm_name = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--workers") && i + 1 < argc)
+      worker_count = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--pin"))
+      pin_workers = true;
+    else if (!strcmp(argv[i], "--checkpoint-every") && i + 1 < argc)
+      checkpoint_seconds = strtod(argv[++i], nullptr);
+    else if (!strcmp(argv[i], "--shm") && i + 1 < argc)
+      shm_name = argv[++i];
+  }
+
   glfwSetErrorCallback(glfw_error_callback);
   if (!glfwInit())
     return 1;
@@ -84,9 +104,13 @@ int main(int, char **)
 
   MazeModel model(MAZE_HEIGHT, MAZE_WIDTH);
   MazeView view(MAZE_HEIGHT, MAZE_WIDTH);
-  MazeController controller;
+  MazeController controller(worker_count, pin_workers);
 
   controller.setModelView(&model, &view);
+  if (checkpoint_seconds >= 0.0)
+    controller.setCheckpoint(MazeController::CHECKPOINT_PATH, checkpoint_seconds);
+  if (shm_name && !controller.publishGrid(shm_name))
+    fprintf(stderr, "failed to create shared memory %s\n", shm_name);
   controller.InitMaze();
 
   view.render(window);